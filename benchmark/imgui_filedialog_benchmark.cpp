@@ -0,0 +1,394 @@
+/*
+	Headless benchmark for ImGuiFileDialog.
+
+	Generates synthetic directories and times the scan, filter and sort passes and whole
+	dialog frames against an ImGui context without a renderer backend. Every result is
+	printed to stdout as one JSON object per line; progress goes to stderr.
+
+	Usage: imgui_filedialog_benchmark [--sizes=1000,100000,1000000] [--iterations=5] [--root=<directory>]
+*/
+
+// Built into the benchmark directly so the internal passes can be timed on their own.
+#include "imgui_filedialog.cpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static const char* benchmarkExtensions[] = { ".png", ".jpg", ".json", ".txt", ".cpp", ".h", ".obj", ".fbx", ".wav", ".tar.gz", ".PNG", "" };
+static const std::vector<std::string> benchmarkFilters = { "Images|.png|.jpg", "Sources|.cpp|.h", "Archives|*.tar.gz", "All|.*" };
+
+struct BenchmarkOptions
+{
+	std::vector<size_t> sizes = { 1000, 100000, 1000000 };
+	int iterations = 5;
+	std::filesystem::path root = std::filesystem::temp_directory_path() / "imgui_filedialog_benchmark";
+};
+
+// Creates one flat directory holding `entries` entries, 1% of them folders. A marker file
+// keeps the tree between runs so only the first run pays for the generation.
+static std::filesystem::path GenerateTree(const std::filesystem::path& root, size_t entries)
+{
+	std::filesystem::path directory = root / ("tree_" + std::to_string(entries));
+	std::filesystem::path marker = root / ("tree_" + std::to_string(entries) + ".complete");
+
+	if (std::filesystem::exists(marker))
+		return directory;
+
+	std::fprintf(stderr, "generating %zu entries in %s\n", entries, directory.string().c_str());
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	size_t directoryCount = entries / 100;
+	for (size_t i = 0; i < entries; ++i)
+	{
+		char name[64];
+		if (i < directoryCount)
+		{
+			std::snprintf(name, sizeof(name), "folder_%07zu", i);
+			std::filesystem::create_directory(directory / name);
+		}
+		else
+		{
+			const char* extension = benchmarkExtensions[i % IM_ARRAYSIZE(benchmarkExtensions)];
+			std::snprintf(name, sizeof(name), "asset_%07zu%s", (i * 7919) % entries, extension);
+
+			// Sizes vary so the size sort has work to do.
+			std::ofstream file(directory / name, std::ios::binary);
+			file << std::string(i % 17, 'x');
+		}
+	}
+
+	std::ofstream(marker) << entries;
+	return directory;
+}
+
+static void Report(const char* name, size_t entries, std::vector<double> times)
+{
+	std::sort(times.begin(), times.end());
+	std::printf("{\"benchmark\":\"%s\",\"entries\":%zu,\"iterations\":%zu,\"min_ms\":%.4f,\"median_ms\":%.4f,\"max_ms\":%.4f}\n",
+		name, entries, times.size(), times.front(), times[times.size() / 2], times.back());
+	std::fflush(stdout);
+}
+
+// Runs `body` once to warm up and then `iterations` times. The body returns the milliseconds
+// it measured itself, so per-iteration setup stays out of the numbers.
+template <typename Body>
+static void Measure(const char* name, size_t entries, int iterations, Body body)
+{
+	body();
+
+	std::vector<double> times;
+	for (int i = 0; i < iterations; ++i)
+		times.push_back(body());
+
+	Report(name, entries, times);
+}
+
+template <typename Work>
+static double Time(Work work)
+{
+	auto start = std::chrono::steady_clock::now();
+	work();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void MakeInfo(ImFileDialogInfo& info, const std::filesystem::path& directory)
+{
+	info = ImFileDialogInfo();
+	info.title = "Benchmark";
+	info.type = ImGuiFileDialogType_OpenFile;
+	info.directoryPath = directory;
+	info.filters = benchmarkFilters;
+	ParseFilters(&info);
+
+	// A service of its own, so no run is served from a listing cached by the one before.
+	info.service = std::make_shared<ImFileDialogService>();
+
+	// Synchronous scans are timed whole, however long they take.
+	info.syncScanTimeoutMs = 1e9;
+	info.scanDeadlineMs = 0.0;
+}
+
+// A listing backend standing in for a network mount that stops answering: it lists `entries`
+// names, then blocks until released, as a hung readdir would.
+struct StalledMount
+{
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool released = false;
+	size_t entries = 0;
+
+	void release()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			released = true;
+		}
+		condition.notify_all();
+	}
+};
+
+static void MakeStalledInfo(ImFileDialogInfo& info, const std::filesystem::path& directory, std::shared_ptr<StalledMount> mount)
+{
+	MakeInfo(info, directory);
+	info.syncScanTimeoutMs = 200.0;
+	info.listDirectory = [mount](const std::filesystem::path&, const std::function<bool(const ImFileDialogDirectoryEntry&)>& visit, std::error_code&)
+		{
+			for (size_t i = 0; i < mount->entries; ++i)
+			{
+				std::string name = "remote_" + std::to_string(i) + ".txt";
+				ImFileDialogDirectoryEntry entry;
+				entry.name = name;
+				if (!visit(entry))
+					return;
+			}
+
+			std::unique_lock<std::mutex> lock(mount->mutex);
+			mount->condition.wait(lock, [&]() { return mount->released; });
+		};
+}
+
+static double Frame(bool* open, ImFileDialogInfo* info)
+{
+	return Time([&]()
+		{
+			ImGui::GetIO().DeltaTime = 1.0f / 60.0f;
+			ImGui::NewFrame();
+			ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+			ImGui::FileDialog(open, info);
+			ImGui::Render();
+		});
+}
+
+static void RunBenchmarks(const std::filesystem::path& directory, size_t entries, int iterations)
+{
+	ImFileDialogInfo info;
+
+	Measure("scan_sync", entries, iterations, [&]()
+		{
+			MakeInfo(info, directory);
+			return Time([&]() { RefreshInfo(&info); });
+		});
+
+	Measure("scan_lazy", entries, iterations, [&]()
+		{
+			MakeInfo(info, directory);
+			info.lazyMetadata = true;
+			return Time([&]() { RefreshInfo(&info); });
+		});
+
+	Measure("scan_async", entries, iterations, [&]()
+		{
+			MakeInfo(info, directory);
+			return Time([&]()
+				{
+					StartScan(&info);
+					while (!info.scan->finished)
+					{
+						ConsumeScan(&info);
+						std::this_thread::sleep_for(std::chrono::microseconds(200));
+					}
+					ConsumeScan(&info);
+				});
+		});
+
+	MakeInfo(info, directory);
+	RefreshInfo(&info);
+
+	Measure("parse_filters", entries, iterations, [&]()
+		{
+			return Time([&]()
+				{
+					info.parsedFilters.clear();
+					ParseFilters(&info);
+				});
+		});
+
+	Measure("filter_match", entries, iterations, [&]()
+		{
+			return Time([&]()
+				{
+					for (size_t i = 0; i < info.currentFiles.size(); ++i)
+						info.currentFiles.setFilterMask(i, MatchFilters(info.parsedFilters, info.currentFiles.name(i)));
+				});
+		});
+
+	static const struct { const char* name; ImGuiFileDialogSortColumn column; } sorts[] = {
+		{ "sort_name", ImGuiFileDialogSortColumn_Name },
+		{ "sort_natural", ImGuiFileDialogSortColumn_NaturalName },
+		{ "sort_size", ImGuiFileDialogSortColumn_Size },
+		{ "sort_type", ImGuiFileDialogSortColumn_Type },
+		{ "sort_date", ImGuiFileDialogSortColumn_Date },
+	};
+
+	for (const auto& sort : sorts)
+	{
+		Measure(sort.name, entries, iterations, [&]()
+			{
+				return Time([&]() { UpdateSortOrder(info.sortedFiles, info.currentFiles, true, sort.column, false); });
+			});
+	}
+
+	Measure("filter_display", entries, iterations, [&]()
+		{
+			return Time([&]()
+				{
+					for (size_t i = 0; i < info.parsedFilters.size(); ++i)
+						UpdateDisplay(info.displayFiles, info.sortedFiles, info.currentFiles, &info.parsedFilters.at(i), i, nullptr);
+				});
+		});
+
+	bool open = true;
+
+	Measure("frame_first", entries, iterations, [&]()
+		{
+			MakeInfo(info, directory);
+			return Frame(&open, &info);
+		});
+
+	Measure("frame", entries, iterations, [&]() { return Frame(&open, &info); });
+
+	Measure("frame_filter_switch", entries, iterations, [&]()
+		{
+			info.currentFilterIndex = (info.currentFilterIndex + 1) % info.parsedFilters.size();
+			info.refreshDisplay = true;
+			return Frame(&open, &info);
+		});
+
+	Measure("frame_sort", entries, iterations, [&]()
+		{
+			info.refreshSort = true;
+			return Frame(&open, &info);
+		});
+
+	// Frames with a cheap extra column and an expensive one that hashes the rows on screen.
+	info.columns.push_back({ "Name length", 60.0f, ImGuiFileDialogColumnCost_Cheap, [](const ImFileDialogColumnEntry& entry)
+		{
+			return std::to_string(entry.path.filename().native().size());
+		} });
+	info.columns.push_back({ "Hash", 90.0f, ImGuiFileDialogColumnCost_Expensive, [](const ImFileDialogColumnEntry& entry)
+		{
+			std::ifstream file(entry.path, std::ios::binary);
+			uint32_t hash = 2166136261u;
+			for (char c; file.get(c);)
+				hash = (hash ^ (uint8_t)c) * 16777619u;
+
+			char text[16];
+			std::snprintf(text, sizeof(text), "%08x", hash);
+			return std::string(text);
+		} });
+
+	Measure("frame_columns", entries, iterations, [&]() { return Frame(&open, &info); });
+
+	info.columns.clear();
+
+	// Frames while the listing backend hangs: the first one waits syncScanTimeoutMs, the rest
+	// must not wait at all.
+	Measure("frame_stalled_mount", entries, iterations, [&]()
+		{
+			auto mount = std::make_shared<StalledMount>();
+			mount->entries = entries;
+			MakeStalledInfo(info, directory, mount);
+
+			Frame(&open, &info);
+			double time = Frame(&open, &info);
+
+			CloseListing(&info);
+			mount->release();
+			return time;
+		});
+
+	// From the start of a scan of a hung backend until the dialog gives up on it.
+	Measure("scan_deadline", entries, iterations, [&]()
+		{
+			auto mount = std::make_shared<StalledMount>();
+			mount->entries = entries;
+			MakeStalledInfo(info, directory, mount);
+			info.scanDeadlineMs = 50.0;
+
+			double time = Time([&]()
+				{
+					StartScan(&info);
+					while (!info.scan->finished)
+					{
+						ConsumeScan(&info);
+						std::this_thread::sleep_for(std::chrono::microseconds(200));
+					}
+				});
+
+			CloseListing(&info);
+			mount->release();
+			return time;
+		});
+
+	// Leave nothing behind that could outlive the tree on the next size.
+	CloseListing(&info);
+}
+
+static bool ParseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+
+		if (argument.rfind("--sizes=", 0) == 0)
+		{
+			options.sizes.clear();
+			std::string list = argument.substr(8);
+			for (size_t start = 0; start < list.size();)
+			{
+				size_t end = list.find(',', start);
+				if (end == std::string::npos)
+					end = list.size();
+				options.sizes.push_back(std::stoull(list.substr(start, end - start)));
+				start = end + 1;
+			}
+		}
+		else if (argument.rfind("--iterations=", 0) == 0)
+		{
+			options.iterations = std::max(1, std::stoi(argument.substr(13)));
+		}
+		else if (argument.rfind("--root=", 0) == 0)
+		{
+			options.root = argument.substr(7);
+		}
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--sizes=1000,100000,1000000] [--iterations=5] [--root=<directory>]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return !options.sizes.empty();
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	if (!ParseOptions(argc, argv, options))
+		return 1;
+
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+	io.DisplaySize = ImVec2(1280.0f, 720.0f);
+	io.IniFilename = nullptr;
+
+	// Without a renderer the font atlas is never uploaded, but NewFrame still needs it built.
+	unsigned char* pixels = nullptr;
+	int width = 0, height = 0;
+	io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+	std::filesystem::create_directories(options.root);
+
+	for (size_t entries : options.sizes)
+	{
+		std::filesystem::path directory = GenerateTree(options.root, entries);
+		std::fprintf(stderr, "running %zu entries\n", entries);
+		RunBenchmarks(directory, entries, options.iterations);
+	}
+
+	ImGui::DestroyContext();
+	return 0;
+}
@@ -8,8 +8,54 @@
 	Changes by Marceli Antosik (Muppetsg2)
 */
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <sstream>
+#include <cctype>
+#include <condition_variable>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <set>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86_FP) && _M_IX86_FP >= 2
+#define IMGUI_FILEDIALOG_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+// Platforms whose readdir reports the entry type, so a listing needs no stat per entry.
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define IMGUI_FILEDIALOG_READDIR
+#include <dirent.h>
+#endif
 
 #include <imgui.h>
 
@@ -17,395 +63,5922 @@
 
 using namespace std::chrono_literals;
 
-typedef int ImGuiFileDialogSortOrder;
+typedef int ImGuiFileDialogSortColumn;
 
-enum ImGuiFileDialogSortOrder_
+enum ImGuiFileDialogSortColumn_
 {
-	ImGuiFileDialogSortOrder_Up,
-	ImGuiFileDialogSortOrder_Down,
-	ImGuiFileDialogSortOrder_None
+	ImGuiFileDialogSortColumn_None,
+	ImGuiFileDialogSortColumn_Name,
+	ImGuiFileDialogSortColumn_NaturalName,
+	ImGuiFileDialogSortColumn_Size,
+	ImGuiFileDialogSortColumn_Type,
+	ImGuiFileDialogSortColumn_Date,
+	ImGuiFileDialogSortColumn_Value
 };
 
-void ParseFilters(ImFileDialogInfo* dialogInfo)
+// One background listing of a directory. Every dialog asking for the same directory with the
+// same type and filters while it runs reads from it instead of starting its own.
+struct ImFileDialogScanJob
 {
-	dialogInfo->parsedFilters.clear();
-	dialogInfo->currentFilterIndex = 0;
+	std::filesystem::path directoryPath;
+	ImGuiFileDialogType type;
+	ordered_map<std::string, ImFileDialogFilter> filters;
+	uint64_t filtersFingerprint;
+	bool lazyMetadata;
+	std::atomic<size_t> maxEntries{ SIZE_MAX };
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+	ImFileDialogListFunction listDirectory;
+
+	std::atomic<bool> cancelled{ false };
+	std::atomic<bool> finished{ false };
+	std::atomic<size_t> scannedEntries{ 0 };
+	std::atomic<size_t> entryErrors{ 0 };
+	std::atomic<uint64_t> filesystemCalls{ 0 };
+	std::atomic<int> subscribers{ 0 };
+	std::filesystem::file_time_type lastWriteTime;
+	std::chrono::steady_clock::time_point started;
+	std::error_code error;
+	double durationMs = 0.0;
+
+	// Set once a dialog gives up on the job while its worker is stuck, which counts the worker
+	// as stalled in the pool of `service` until the job finishes.
+	std::weak_ptr<ImFileDialogService> service;
+	bool abandoned = false;
+
+	// Everything listed so far; subscribers copy what they have not seen yet.
+	std::mutex mutex;
+	std::condition_variable done;
+	ImFileDialogEntryList files;
+	ImFileDialogEntryList directories;
+};
+
+// A dialog's view of a scan job. The job is released once the dialog holds the whole listing,
+// and cancelled when the last dialog reading it lets go.
+struct ImFileDialogScan
+{
+	std::shared_ptr<ImFileDialogScanJob> job;
+	size_t consumedFiles = 0;
+	size_t consumedDirectories = 0;
+	bool owner = false;
+
+	// When the job began reading the folder, known once it finished.
+	std::chrono::steady_clock::time_point started;
+
+	bool finished = false;
+	size_t scannedEntries = 0;
+	size_t entryErrors = 0;
+	std::error_code error;
+
+	~ImFileDialogScan()
+	{
+		release();
+	}
+
+	void release()
+	{
+		if (job && --job->subscribers == 0)
+			job->cancelled = true;
+		job.reset();
+	}
+};
+
+struct ImFileDialogWalkTask
+{
+	std::filesystem::path directoryPath;
+	std::filesystem::path relativePath;
+#ifdef _WIN32
+	std::filesystem::path canonicalPath;
+#endif
+	int depth = 0;
+};
+
+struct ImFileDialogWalkQueue
+{
+	std::mutex mutex;
+	std::deque<ImFileDialogWalkTask> tasks;
+};
+
+struct ImFileDialogWalk
+{
+	std::filesystem::path directoryPath;
+	ImGuiFileDialogType type;
+	ordered_map<std::string, ImFileDialogFilter> filters;
+	std::string query;
+	bool fuzzy;
+	int maxDepth;
+	size_t maxResults;
+
+	std::atomic<bool> cancelled{ false };
+	std::atomic<bool> finished{ false };
+	std::atomic<bool> truncated{ false };
+	std::atomic<size_t> scannedDirectories{ 0 };
+	std::atomic<size_t> results{ 0 };
+	std::atomic<size_t> pendingTasks{ 0 };
+	std::atomic<size_t> runningWorkers{ 0 };
+	std::atomic<uint64_t> filesystemCalls{ 0 };
+
+	// One queue per worker; owners pop from the back, thieves from the front. Workers with
+	// nothing to pop wait on `wake` until a task is queued or the walk ends.
+	std::vector<std::unique_ptr<ImFileDialogWalkQueue>> queues;
+	std::atomic<size_t> queuedTasks{ 0 };
+	std::mutex idleMutex;
+	std::condition_variable wake;
+
+	// Every directory entered, so symlink cycles are walked once: by device and inode, or by
+	// canonical path where stat has no inode.
+	std::mutex visitedMutex;
+#ifdef _WIN32
+	std::unordered_set<std::filesystem::path::string_type> visited;
+#else
+	std::set<std::pair<uint64_t, uint64_t>> visited;
+#endif
+
+	std::mutex mutex;
+	ImFileDialogEntryList pendingFiles;
+	ImFileDialogEntryList pendingDirectories;
+
+	// Owned by the UI thread.
+	ImFileDialogEntryList files;
+	ImFileDialogEntryList directories;
+};
+
+// Entries re-read on a worker for the names of one batch of change events.
+struct ImFileDialogWatchChanges
+{
+	std::unordered_set<std::string> names;
+	std::atomic<bool> finished{ false };
+	ImFileDialogEntryList files;
+	ImFileDialogEntryList directories;
+	uint64_t filesystemCalls = 0;
+};
+
+// The watch is added on a worker and is only read once `ready` is set. A listing read before
+// `readyTime` may have missed changes the watch never saw; `caughtUp` is set once the dialog
+// has dealt with that.
+struct ImFileDialogWatch
+{
+	std::filesystem::path directoryPath;
+	std::atomic<bool> ready{ false };
+	std::chrono::steady_clock::time_point readyTime;
+	bool caughtUp = false;
+	std::shared_ptr<ImFileDialogWatchChanges> changes;
+#ifdef __linux__
+	int fd = -1;
+
+	~ImFileDialogWatch()
+	{
+		if (fd >= 0)
+			close(fd);
+	}
+#endif
+};
+
+struct ImFileDialogMetadataRequest
+{
+	bool isDirectory;
+	uint32_t index;
+	std::string name;
+};
+
+struct ImFileDialogMetadataResult
+{
+	bool isDirectory;
+	uint32_t index;
+	std::uintmax_t size;
+	std::filesystem::file_time_type lastWriteTime;
+};
+
+struct ImFileDialogMetadata
+{
+	std::filesystem::path directoryPath;
+
+	std::atomic<bool> cancelled{ false };
+	std::atomic<uint64_t> filesystemCalls{ 0 };
+
+	// Rows on screen are served first, top to bottom; the bulk queue fills in the rest for sorting.
+	std::mutex mutex;
+	std::deque<ImFileDialogMetadataRequest> visible;
+	std::deque<ImFileDialogMetadataRequest> bulk;
+	std::list<ImFileDialogMetadataRequest> running;
+	std::vector<ImFileDialogMetadataResult> results;
+	unsigned workers = 0;
+
+	// Owned by the UI thread.
+	size_t bulkFiles = 0;
+	size_t bulkDirectories = 0;
+	bool sortStale = false;
+};
+
+struct ImFileDialogFolderSizeRequest
+{
+	uint32_t index;
+	std::string name;
+};
+
+struct ImFileDialogFolderSizeResult
+{
+	uint32_t index;
+	std::uintmax_t size;
+};
+
+struct ImFileDialogFolderSizes
+{
+	std::filesystem::path directoryPath;
+
+	std::atomic<bool> cancelled{ false };
+	std::atomic<uint64_t> filesystemCalls{ 0 };
+
+	std::mutex mutex;
+	std::deque<ImFileDialogFolderSizeRequest> requests;
+	std::list<ImFileDialogFolderSizeRequest> running;
+	std::vector<ImFileDialogFolderSizeResult> results;
+	unsigned workers = 0;
+
+	// Owned by the UI thread.
+	size_t queued = 0;
+	size_t pending = 0;
+	bool sortStale = false;
+};
+
+struct ImFileDialogFolderSize
+{
+	std::filesystem::file_time_type lastWriteTime;
+	std::uintmax_t size;
+};
+
+struct ImFileDialogColumnRequest
+{
+	uint32_t column;
+	bool isDirectory;
+	bool bulk;
+	uint32_t index;
+	ImFileDialogColumnEntry entry;
+};
+
+struct ImFileDialogColumnResult
+{
+	uint32_t column;
+	bool isDirectory;
+	bool bulk;
+	uint32_t index;
+	std::string value;
+};
+
+struct ImFileDialogColumnValue
+{
+	std::filesystem::file_time_type lastWriteTime;
+	std::string value;
+};
+
+// Computed values of one expensive column for the listing on screen, by entry index.
+struct ImFileDialogColumnCells
+{
+	std::unordered_map<uint32_t, std::string> files;
+	std::unordered_map<uint32_t, std::string> directories;
+	size_t bulkFiles = 0;
+	size_t bulkDirectories = 0;
+	size_t pending = 0;
+};
+
+struct ImFileDialogColumnValues
+{
+	// The providers and names the values were computed with, and the keys of their cached
+	// values; expensive columns only.
+	std::vector<std::string> names;
+	std::vector<std::string> cacheKeys;
+	std::vector<std::function<std::string(const ImFileDialogColumnEntry&)>> providers;
+
+	std::atomic<bool> cancelled{ false };
+	std::atomic<uint64_t> filesystemCalls{ 0 };
+
+	// Rows on screen are served first; the bulk queue fills in the rest for sorting.
+	std::mutex mutex;
+	std::deque<ImFileDialogColumnRequest> visible;
+	std::deque<ImFileDialogColumnRequest> bulk;
+	std::list<ImFileDialogColumnRequest> running;
+	std::vector<ImFileDialogColumnResult> results;
+	unsigned workers = 0;
+
+	// Owned by the UI thread.
+	std::vector<ImFileDialogColumnCells> cells;
+	bool sortStale = false;
+};
+
+struct ImFileDialogListing
+{
+	std::filesystem::path directoryPath;
+	std::filesystem::file_time_type lastWriteTime;
+	ImGuiFileDialogType type;
+	uint64_t filtersFingerprint;
+	bool lazyMetadata;
+	size_t bytes;
+
+	ImFileDialogEntryList files;
+	ImFileDialogEntryList directories;
+};
+
+struct ImFileDialogCache
+{
+	// Most recently used listing first.
+	std::list<ImFileDialogListing> listings;
+	size_t bytes = 0;
+};
+
+struct ImFileDialogWorkerPool
+{
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<std::function<void()>> tasks;
+	unsigned threads = 0;
+	unsigned idleThreads = 0;
+
+	// Threads stuck in a listing the dialogs gave up on. They do not count against
+	// poolMaxThreads, so hung mounts cannot starve the rest of the work.
+	unsigned stalledThreads = 0;
+};
+
+// The status of one path, read on a worker so that a stalled mount never blocks a frame.
+struct ImFileDialogPathCheck
+{
+	std::filesystem::path path;
+	std::atomic<bool> finished{ false };
+	bool exists = false;
+	bool isDirectory = false;
+	bool isRegularFile = false;
+	std::filesystem::file_time_type lastWriteTime = ImFileDialogEntryList::unknownTime;
+	std::error_code error;
+
+	// The place list the folder was picked from, which drops it when it is gone.
+	std::vector<std::filesystem::path>* places = nullptr;
+};
+
+// The places file, read on a worker.
+struct ImFileDialogPlacesLoad
+{
+	std::filesystem::path placesFile;
+	size_t recentMaxEntries = 0;
+
+	std::mutex mutex;
+	std::condition_variable done;
+	std::atomic<bool> finished{ false };
+	std::vector<std::filesystem::path> bookmarks;
+	std::vector<std::filesystem::path> recentDirectories;
+};
+
+// What the preview pane shows for one file. Immutable once published.
+struct ImFileDialogPreviewData
+{
+	std::filesystem::path path;
+	std::filesystem::file_time_type lastWriteTime;
+	std::uintmax_t fileSize = 0;
+	std::string format;
+	std::vector<std::string> details;
+	std::string head;
+	std::string error;
+	size_t bytes = 0;
+};
+
+struct ImFileDialogPreview
+{
+	std::filesystem::path path;
+	std::atomic<bool> cancelled{ false };
+	std::atomic<bool> finished{ false };
+	std::shared_ptr<const ImFileDialogPreviewData> data;
+};
+
+// Read-only view of a whole file. Pages are only read when touched, so mapping a file of several
+// gigabytes costs nothing until its bytes are looked at.
+struct ImFileDialogMappedFile
+{
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE mapping = nullptr;
+#endif
+
+	~ImFileDialogMappedFile()
+	{
+#ifdef _WIN32
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+#else
+		if (data)
+			munmap((void*)data, size);
+#endif
+	}
+};
+
+struct ImFileDialogService
+{
+	ImFileDialogWorkerPool pool;
+
+	std::mutex mutex;
+	ImFileDialogCache cache;
+	std::vector<std::weak_ptr<ImFileDialogScanJob>> scans;
+
+	// Most recently shown preview first.
+	std::list<std::shared_ptr<const ImFileDialogPreviewData>> previews;
+	size_t previewBytes = 0;
+
+	// Recursive sizes by folder path, valid while the folder's write time is unchanged.
+	std::unordered_map<std::filesystem::path::string_type, ImFileDialogFolderSize> folderSizes;
+
+	// Expensive column values by column name and path, valid while the entry's write time is unchanged.
+	std::unordered_map<std::string, ImFileDialogColumnValue> columnValues;
+
+	std::atomic<unsigned> speculativeScans{ 0 };
+
+	// Places files are written one at a time, newest save last.
+	std::mutex placesMutex;
+	std::atomic<uint64_t> placesSaves{ 0 };
+	uint64_t placesWritten = 0;
+};
+
+// The editable path. While it is edited, `index` holds the sub-folders of the folder the text
+// names, as (lowercase name, name) pairs sorted for prefix lookups. It is built from a cached
+// listing; a folder missing from the cache is listed in the background and indexed once it lands.
+struct ImFileDialogPathBar
+{
+	std::string text;
+	bool editing = false;
+	bool suggestionsHovered = false;
+	bool notFound = false;
+
+	std::filesystem::path indexPath;
+	bool indexReady = false;
+	bool indexRequested = false;
+	std::vector<std::pair<std::string, std::string>> index;
+};
+
+struct ImFileDialogTreeNode
+{
+	std::filesystem::path path;
+	std::string name;
+	uint32_t depth = 0;
+	uint32_t firstChild = 0;
+	uint32_t childCount = 0;
+	bool expanded = false;
+	bool listed = false;
+
+	// The folder's write time when its sub-folders were listed.
+	std::filesystem::file_time_type lastWriteTime = ImFileDialogEntryList::unknownTime;
+
+	// The scan listing the node's sub-folders, until it finishes.
+	std::shared_ptr<ImFileDialogScanJob> job;
+};
+
+// The write times of the expanded folders of the tree, read on a worker.
+struct ImFileDialogTreeCheck
+{
+	std::vector<std::pair<uint32_t, std::filesystem::path>> nodes;
+	std::vector<std::filesystem::file_time_type> lastWriteTimes;
+	std::atomic<bool> finished{ false };
+};
+
+// The sidebar's folder tree. A node's children are added together each time it is listed, so
+// they sit next to each other in `nodes`. `rows` holds the nodes shown, in drawing order.
+struct ImFileDialogTree
+{
+	std::vector<ImFileDialogTreeNode> nodes;
+	std::vector<uint32_t> rows;
+	std::vector<uint32_t> listing;
+	bool rowsStale = true;
+
+	// Children replaced when their parent was listed again, dropped once they are half the nodes.
+	size_t orphanedNodes = 0;
+
+	// The folder on screen is revealed once per visit: the folders above it are expanded as
+	// their listings arrive, then it is scrolled into view.
+	std::filesystem::path revealedPath;
+	bool revealing = false;
+	uint32_t scrollTo = UINT32_MAX;
+
+	// Expanded folders are listed again when their write time changes; a refreshed one is
+	// listed again from the dialog's own listing.
+	std::shared_ptr<ImFileDialogTreeCheck> check;
+	std::chrono::steady_clock::time_point nextCheck;
+	std::filesystem::path refreshedPath;
+
+	~ImFileDialogTree()
+	{
+		for (uint32_t index : listing)
+		{
+			if (--nodes[index].job->subscribers == 0)
+				nodes[index].job->cancelled = true;
+		}
+	}
+};
+
+// Folders listed ahead of a double-click. `pending` follows the folder under the pointer or the
+// selected one; finished listings wait in `ready`, most recent first, until one is opened.
+struct ImFileDialogSpeculation
+{
+	std::filesystem::path hoveredPath;
+	double hoverStart = 0.0;
+
+	std::shared_ptr<ImFileDialogScanJob> pending;
+	std::deque<std::shared_ptr<ImFileDialogScanJob>> ready;
+};
+
+static const size_t scanBatchSize = 256;
+static const auto scanBatchInterval = 16ms;
+static const size_t parallelSortThreshold = 1 << 16;
+static const unsigned walkMaxWorkers = 4;
+static const unsigned metadataMaxWorkers = 4;
+static const unsigned poolMaxThreads = 16;
+static const unsigned poolMaxStalledThreads = 64;
+static const unsigned folderSizeMaxWorkers = 4;
+static const size_t folderSizeCacheMaxEntries = 1 << 16;
+static const unsigned columnMaxWorkers = 4;
+static const size_t columnCacheMaxEntries = 1 << 18;
+static const double speculativeHoverDelay = 0.15;
+static const unsigned speculativeMaxScans = 2;
+static const size_t speculativeMaxListings = 4;
+static const size_t speculativeMaxEntries = 1 << 17;
+static const size_t pathBufferSize = 1024;
+static const size_t pathSuggestionsMax = 8;
+static const float previewWidth = 260.0f;
+static const float placesWidth = 160.0f;
+static const float treeWidth = 200.0f;
+static const auto treeCheckInterval = 2s;
+static const size_t previewHeadBytes = 4096;
+static const size_t previewHeadLines = 40;
+static const size_t previewHexBytes = 512;
+static const size_t previewJsonBytes = 1 << 20;
+static const size_t previewJsonKeys = 32;
+static const size_t previewTarMaxEntries = 1 << 20;
+static const auto poolIdleTimeout = 5s;
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Adds the time until the end of the scope to a counter of ImFileDialogStats.
+struct ImFileDialogTimer
+{
+	double& target;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	~ImFileDialogTimer()
+	{
+		target += ElapsedMs(start);
+	}
+};
+
+// Orders entry indices by the columns of ImFileDialogEntryList. Ties fall back to the
+// index so that incremental merges and parallel chunks agree on one total order.
+struct ImFileDialogEntryCompare
+{
+	const ImFileDialogEntryList* entries;
+	ImGuiFileDialogSortColumn column;
+	bool descending;
+	const std::vector<std::string>* values = nullptr;
+
+	bool operator()(uint32_t a, uint32_t b) const
+	{
+		int result = 0;
+
+		switch (column)
+		{
+		case ImGuiFileDialogSortColumn_Name:
+			result = entries->name(a).compare(entries->name(b));
+			break;
+		case ImGuiFileDialogSortColumn_NaturalName:
+			result = entries->collationKey(a).compare(entries->collationKey(b));
+			if (result == 0)
+				result = entries->name(a).compare(entries->name(b));
+			break;
+		case ImGuiFileDialogSortColumn_Size:
+			result = entries->fileSize(a) < entries->fileSize(b) ? -1 : entries->fileSize(a) > entries->fileSize(b) ? 1 : 0;
+			break;
+		case ImGuiFileDialogSortColumn_Type:
+			result = entries->extension(a).compare(entries->extension(b));
+			break;
+		case ImGuiFileDialogSortColumn_Date:
+			result = entries->lastWriteTime(a) < entries->lastWriteTime(b) ? -1 : entries->lastWriteTime(a) > entries->lastWriteTime(b) ? 1 : 0;
+			break;
+		case ImGuiFileDialogSortColumn_Value:
+			result = (*values)[a].compare((*values)[b]);
+			break;
+		}
+
+		if (result == 0)
+			return a < b;
+
+		return descending ? result > 0 : result < 0;
+	}
+};
+
+// Splits large ranges into power-of-two chunks sorted on separate threads, then merges them pairwise.
+template <typename Iterator, typename Compare>
+static void ParallelSort(Iterator first, Iterator last, Compare compare, size_t threadCount = std::thread::hardware_concurrency())
+{
+	size_t count = last - first;
+
+	if (count < parallelSortThreshold || threadCount < 2)
+	{
+		std::sort(first, last, compare);
+		return;
+	}
+
+	size_t chunkCount = 1;
+	while (chunkCount * 2 <= threadCount && count / (chunkCount * 2) >= parallelSortThreshold / 4)
+		chunkCount *= 2;
+
+	std::vector<Iterator> bounds(chunkCount + 1);
+	for (size_t i = 0; i <= chunkCount; ++i)
+		bounds[i] = first + count * i / chunkCount;
+
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < chunkCount; ++i)
+		workers.emplace_back([&bounds, &compare, i]() { std::sort(bounds[i], bounds[i + 1], compare); });
+
+	std::sort(bounds[0], bounds[1], compare);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	for (size_t width = 1; width < chunkCount; width *= 2)
+	{
+		workers.clear();
+		for (size_t i = 2 * width; i < chunkCount; i += 2 * width)
+			workers.emplace_back([&bounds, &compare, i, width]() { std::inplace_merge(bounds[i], bounds[i + width], bounds[i + 2 * width], compare); });
+
+		std::inplace_merge(bounds[0], bounds[width], bounds[2 * width], compare);
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+}
+
+typedef std::pair<uint64_t, uint32_t> ImFileDialogKeyWindow;
+
+// Sorts entries by the 8 bytes of their key starting at `offset`, read big-endian, then sorts
+// each run of equal windows by the next 8 bytes. Names and keys never hold a zero byte, so a
+// window padded with zeros marks a key that ended; such runs are settled by the full compare.
+static void SortKeyWindows(std::vector<ImFileDialogKeyWindow>::iterator first, std::vector<ImFileDialogKeyWindow>::iterator last, size_t offset, const ImFileDialogEntryCompare& compare)
+{
+	for (auto it = first; it != last; ++it)
+	{
+		std::string_view key = compare.column == ImGuiFileDialogSortColumn_NaturalName ? compare.entries->collationKey(it->second) : compare.entries->name(it->second);
+		uint64_t window = 0;
+		for (size_t i = offset; i < offset + 8; ++i)
+			window = window << 8 | (i < key.size() ? (uint8_t)key[i] : 0);
+		it->first = window;
+	}
+
+	auto byWindow = [&compare](const ImFileDialogKeyWindow& a, const ImFileDialogKeyWindow& b)
+	{
+		return compare.descending ? a.first > b.first : a.first < b.first;
+	};
+
+	// Runs further down are small; only the first pass is worth splitting across threads.
+	if (offset == 0)
+		ParallelSort(first, last, byWindow);
+	else
+		std::sort(first, last, byWindow);
+
+	for (auto runStart = first; runStart != last;)
+	{
+		auto runEnd = runStart + 1;
+		while (runEnd != last && runEnd->first == runStart->first)
+			++runEnd;
+
+		if (runEnd - runStart > 1)
+		{
+			if ((runStart->first & 0xff) == 0)
+				std::sort(runStart, runEnd, [&compare](const ImFileDialogKeyWindow& a, const ImFileDialogKeyWindow& b) { return compare(a.second, b.second); });
+			else
+				SortKeyWindows(runStart, runEnd, offset + 8, compare);
+		}
+
+		runStart = runEnd;
+	}
+}
+
+// Name sorts compare integers taken from the keys instead of the keys themselves, so most
+// comparisons stay within one array instead of chasing names across the arena.
+static void SortByKeyWindows(std::vector<uint32_t>::iterator first, std::vector<uint32_t>::iterator last, const ImFileDialogEntryCompare& compare)
+{
+	std::vector<ImFileDialogKeyWindow> windows(last - first);
+	for (size_t i = 0; i < windows.size(); ++i)
+		windows[i].second = first[i];
+
+	SortKeyWindows(windows.begin(), windows.end(), 0, compare);
+
+	for (size_t i = 0; i < windows.size(); ++i)
+		first[i] = windows[i].second;
+}
+
+// Keeps a cached permutation of the entries. A full sort only happens when the sort key or the
+// listing changed; entries appended by a running scan are sorted on their own and merged in.
+// `values` holds the text of every entry when sorting by an extra column.
+static bool UpdateSortOrder(std::vector<uint32_t>& order, const ImFileDialogEntryList& entries, bool rebuild, ImGuiFileDialogSortColumn column, bool descending, const std::vector<std::string>* values = nullptr)
+{
+	bool changed = rebuild || order.size() > entries.size();
+	if (changed)
+		order.clear();
+
+	if (order.size() == entries.size())
+		return changed;
+
+	size_t sortedCount = order.size();
+	order.resize(entries.size());
+	std::iota(order.begin() + sortedCount, order.end(), (uint32_t)sortedCount);
+
+	if (column == ImGuiFileDialogSortColumn_None)
+		return true;
+
+	ImFileDialogEntryCompare compare = { &entries, column, descending, values };
+	if (column == ImGuiFileDialogSortColumn_Name || column == ImGuiFileDialogSortColumn_NaturalName)
+		SortByKeyWindows(order.begin() + sortedCount, order.end(), compare);
+	else
+		ParallelSort(order.begin() + sortedCount, order.end(), compare);
+
+	if (sortedCount > 0)
+		std::inplace_merge(order.begin(), order.begin() + sortedCount, order.end(), compare);
+
+	return true;
+}
+
+// Projects the sorted permutation through the active filter. This is the only work a filter
+// switch costs: the listing itself keeps every entry together with its filter bitmask.
+static void UpdateDisplay(std::vector<uint32_t>& display, const std::vector<uint32_t>& order, const ImFileDialogEntryList& entries, const ImFileDialogFilter* filter, size_t filterIndex, const std::vector<uint8_t>* searchMatches)
+{
+	display.clear();
+
+	if (!filter && !searchMatches)
+	{
+		display = order;
+		return;
+	}
+
+	display.reserve(order.size());
+	uint64_t bit = filter && filterIndex < 64 ? 1ull << filterIndex : 0;
+
+	for (uint32_t index : order)
+	{
+		if (searchMatches && !(*searchMatches)[index])
+			continue;
+
+		if (filter && !(bit ? entries.filterMask(index) & bit : filter->matches(entries.fileName(index))))
+			continue;
+
+		display.push_back(index);
+	}
+}
+
+static char ToLower(char c)
+{
+	return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+static std::string ToLower(std::string text)
+{
+	for (char& c : text)
+		c = ToLower(c);
+
+	return text;
+}
+
+// Case-insensitive FNV-1a, so lookups hash the name in place instead of lowering a copy.
+static uint64_t HashLower(std::string_view text)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (char c : text)
+	{
+		hash ^= (unsigned char)ToLower(c);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static bool EqualsLower(std::string_view text, std::string_view lower)
+{
+	if (text.size() != lower.size())
+		return false;
+
+	for (size_t i = 0; i < text.size(); ++i)
+	{
+		if (ToLower(text[i]) != lower[i])
+			return false;
+	}
+
+	return true;
+}
+
+static std::string_view ExtensionOf(std::string_view fileName)
+{
+	size_t dot = fileName.rfind('.');
+	if (dot == std::string_view::npos || dot == 0)
+		return std::string_view();
+
+	return fileName.substr(dot);
+}
+
+// Matches one character against a "[...]" class starting at pattern[p]. On return p points past the class.
+static bool MatchClass(std::string_view pattern, size_t& p, char c)
+{
+	size_t start = ++p;
+	bool negate = p < pattern.size() && (pattern[p] == '!' || pattern[p] == '^');
+	if (negate)
+		start = ++p;
+
+	bool matched = false;
+	while (p < pattern.size() && (pattern[p] != ']' || p == start))
+	{
+		char low = pattern[p];
+		char high = low;
+
+		if (p + 2 < pattern.size() && pattern[p + 1] == '-' && pattern[p + 2] != ']')
+		{
+			high = pattern[p + 2];
+			p += 2;
+		}
+
+		if (c >= low && c <= high)
+			matched = true;
+
+		p++;
+	}
+
+	if (p < pattern.size())
+		p++;
+
+	return matched != negate;
+}
+
+// Iterative glob matching with a single backtrack point for the last '*'. Both sides are compared lowercase.
+static bool MatchGlob(std::string_view pattern, std::string_view text)
+{
+	size_t p = 0;
+	size_t t = 0;
+	size_t starPattern = std::string_view::npos;
+	size_t starText = 0;
+
+	while (t < text.size())
+	{
+		char c = ToLower(text[t]);
+
+		if (p < pattern.size() && pattern[p] == '*')
+		{
+			starPattern = ++p;
+			starText = t;
+			continue;
+		}
+
+		if (p < pattern.size())
+		{
+			size_t next = p;
+			bool matched = false;
+
+			if (pattern[p] == '[')
+				matched = MatchClass(pattern, next, c);
+			else
+				matched = pattern[next++] == '?' || pattern[p] == c;
+
+			if (matched)
+			{
+				p = next;
+				t++;
+				continue;
+			}
+		}
+
+		if (starPattern == std::string_view::npos)
+			return false;
+
+		p = starPattern;
+		t = ++starText;
+	}
+
+	while (p < pattern.size() && pattern[p] == '*')
+		p++;
+
+	return p == pattern.size();
+}
+
+void ImFileDialogFilter::insertExtension(std::string extension)
+{
+	if ((extensionCount + 1) * 2 > extensionTable.size())
+	{
+		std::vector<std::string> table(std::max<size_t>(8, extensionTable.size() * 2));
+		for (std::string& existing : extensionTable)
+		{
+			if (existing.empty())
+				continue;
+
+			size_t slot = HashLower(existing) & (table.size() - 1);
+			while (!table[slot].empty())
+				slot = (slot + 1) & (table.size() - 1);
+			table[slot] = std::move(existing);
+		}
+		extensionTable = std::move(table);
+	}
+
+	size_t slot = HashLower(extension) & (extensionTable.size() - 1);
+	while (!extensionTable[slot].empty())
+	{
+		if (extensionTable[slot] == extension)
+			return;
+		slot = (slot + 1) & (extensionTable.size() - 1);
+	}
+
+	extensionTable[slot] = std::move(extension);
+	extensionCount++;
+}
+
+void ImFileDialogFilter::add(const std::string& pattern)
+{
+	if (pattern.empty())
+		return;
+
+	patterns.push_back(pattern);
+
+	if (pattern == "*" || pattern == ".*" || pattern == "*.*")
+	{
+		matchAll = true;
+		return;
+	}
+
+	std::string lower = ToLower(pattern);
+	bool hasWildcard = lower.find_first_of("*?[") != std::string::npos;
+
+	// Only the last extension of a name is looked up, so ".tar.gz" is matched as "*.tar.gz".
+	if (!hasWildcard && lower[0] == '.' && lower.find('.', 1) != std::string::npos)
+	{
+		globs.push_back("*" + lower);
+	}
+	else if (!hasWildcard && lower[0] == '.')
+	{
+		insertExtension(lower);
+	}
+	else if (lower.size() > 2 && lower[0] == '*' && lower[1] == '.' && lower.find_first_of("*?[.", 2) == std::string::npos)
+	{
+		insertExtension(lower.substr(1));
+	}
+	else
+	{
+		globs.push_back(lower);
+	}
+}
+
+bool ImFileDialogFilter::matches(std::string_view fileName) const
+{
+	if (matchAll)
+		return true;
+
+	if (extensionCount > 0)
+	{
+		std::string_view extension = ExtensionOf(fileName);
+		if (!extension.empty())
+		{
+			size_t slot = HashLower(extension) & (extensionTable.size() - 1);
+			while (!extensionTable[slot].empty())
+			{
+				if (EqualsLower(extension, extensionTable[slot]))
+					return true;
+				slot = (slot + 1) & (extensionTable.size() - 1);
+			}
+		}
+	}
+
+	for (const std::string& glob : globs)
+	{
+		if (MatchGlob(glob, fileName))
+			return true;
+	}
+
+	return false;
+}
+
+void ParseFilters(ImFileDialogInfo* dialogInfo)
+{
+	dialogInfo->parsedFilters.clear();
+	dialogInfo->currentFilterIndex = 0;
+
+	std::vector<std::string> actualFilters = dialogInfo->filters;
+	if (actualFilters.empty()) {
+		actualFilters.push_back("All Files (*.*)|.*");
+	}
+
+	for (size_t i = 0; i < actualFilters.size(); ++i) {
+		std::string activeFilter = actualFilters[i];
+		std::string filterName = activeFilter.substr(0, activeFilter.find("|"));
+		std::string filterExtensions = activeFilter.substr(activeFilter.find("|") + 1);
+
+		dialogInfo->parsedFilters.insert(filterName, {});
+
+		bool hasWildcard = false;
+		std::vector<std::string> extensions;
+
+		size_t pos = 0;
+		while ((pos = filterExtensions.find("|")) != std::string::npos) {
+			std::string ext = filterExtensions.substr(0, pos);
+			filterExtensions.erase(0, pos + 1);
+
+			if (ext == ".*") {
+				hasWildcard = true;
+				break;
+			}
+
+			extensions.push_back(ext);
+		}
+
+		if (!hasWildcard && !filterExtensions.empty()) {
+			std::string ext = filterExtensions;
+
+			if (ext == ".*") {
+				hasWildcard = true;
+			}
+			else {
+				extensions.push_back(ext);
+			}
+		}
+
+		if (hasWildcard) {
+			dialogInfo->parsedFilters[filterName].add("*");
+		}
+		else {
+			for (const std::string& extension : extensions)
+				dialogInfo->parsedFilters[filterName].add(extension);
+
+			if (dialogInfo->parsedFilters[filterName].empty())
+				dialogInfo->parsedFilters.remove(filterName);
+		}
+	}
+}
+
+// Evaluates every parsed filter in one pass. Bit i is set when filter i accepts the file;
+// filters past the 64th are evaluated when the listing is projected instead.
+static uint64_t MatchFilters(const ordered_map<std::string, ImFileDialogFilter>& filters, std::string_view fileName)
+{
+	uint64_t mask = 0;
+	size_t count = std::min<size_t>(filters.size(), 64);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (filters.at(i).matches(fileName))
+			mask |= 1ull << i;
+	}
+
+	return mask;
+}
+
+static uint64_t FiltersFingerprint(const ordered_map<std::string, ImFileDialogFilter>& filters)
+{
+	uint64_t fingerprint = filters.size();
+
+	for (size_t i = 0; i < filters.size(); ++i)
+	{
+		fingerprint = fingerprint * 31 + HashLower(filters.keyAt(i));
+		for (const std::string& pattern : filters.at(i).source())
+			fingerprint = fingerprint * 31 + HashLower(pattern);
+	}
+
+	return fingerprint;
+}
+
+// Lowercase copy of every name in one buffer, each name terminated by '\0'. Queries never
+// contain '\0', so a match found by scanning the whole buffer never spans two names.
+struct ImFileDialogSearchList
+{
+	std::string names;
+	std::vector<uint32_t> offsets;
+	std::vector<uint8_t> matched;
+	std::vector<uint32_t> matches;
+};
+
+struct ImFileDialogSearch
+{
+	std::string query;
+	bool fuzzy = false;
+	ImFileDialogSearchList files;
+	ImFileDialogSearchList directories;
+};
+
+static bool MatchSubsequence(std::string_view name, std::string_view query)
+{
+	const char* cursor = name.data();
+	const char* end = name.data() + name.size();
+
+	for (char c : query)
+	{
+		cursor = (const char*)std::memchr(cursor, c, end - cursor);
+		if (!cursor)
+			return false;
+		cursor++;
+	}
+
+	return true;
+}
+
+static bool MatchSearch(const ImFileDialogSearchList& list, uint32_t index, std::string_view query, bool fuzzy)
+{
+	std::string_view name(list.names.data() + list.offsets[index], list.offsets[index + 1] - list.offsets[index] - 1);
+	return fuzzy ? MatchSubsequence(name, query) : name.find(query) != std::string_view::npos;
+}
+
+#ifdef IMGUI_FILEDIALOG_SSE2
+static int CountTrailingZeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long bit;
+	_BitScanForward(&bit, mask);
+	return (int)bit;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Reports the start of every occurrence of query in names. With SSE2, 16 candidate positions
+// are tested at once by comparing the first and the last byte of the query before the memcmp.
+template <typename Callback>
+static void FindAll(const std::string& names, std::string_view query, Callback callback)
+{
+	size_t position = 0;
+	size_t length = query.size();
+
+#ifdef IMGUI_FILEDIALOG_SSE2
+	const __m128i first = _mm_set1_epi8(query.front());
+	const __m128i last = _mm_set1_epi8(query.back());
+
+	for (; position + length - 1 + 16 <= names.size(); position += 16)
+	{
+		__m128i blockFirst = _mm_loadu_si128((const __m128i*)(names.data() + position));
+		__m128i blockLast = _mm_loadu_si128((const __m128i*)(names.data() + position + length - 1));
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+
+		for (; mask != 0; mask &= mask - 1)
+		{
+			size_t candidate = position + CountTrailingZeros(mask);
+			if (length <= 2 || std::memcmp(names.data() + candidate + 1, query.data() + 1, length - 2) == 0)
+				callback(candidate);
+		}
+	}
+#endif
+
+	std::string_view haystack(names);
+	while ((position = haystack.find(query, position)) != std::string_view::npos)
+		callback(position++);
+}
+
+static void IndexNames(ImFileDialogSearchList& list, const ImFileDialogEntryList& entries)
+{
+	if (list.offsets.empty())
+		list.offsets.push_back(0);
+
+	for (size_t i = list.offsets.size() - 1; i < entries.size(); ++i)
+	{
+		for (char c : entries.name(i))
+			list.names.push_back(ToLower(c));
+		list.names.push_back('\0');
+		list.offsets.push_back((uint32_t)list.names.size());
+	}
+
+	list.matched.resize(entries.size(), 0);
+}
+
+static void SearchAll(ImFileDialogSearchList& list, std::string_view query, bool fuzzy)
+{
+	std::fill(list.matched.begin(), list.matched.end(), 0);
+	list.matches.clear();
+
+	if (fuzzy)
+	{
+		for (uint32_t i = 0; i + 1 < list.offsets.size(); ++i)
+		{
+			if (MatchSearch(list, i, query, fuzzy))
+				list.matches.push_back(i);
+		}
+	}
+	else
+	{
+		uint32_t index = 0;
+		FindAll(list.names, query, [&list, &index](size_t position)
+			{
+				while (list.offsets[index + 1] <= position)
+					index++;
+
+				if (list.matches.empty() || list.matches.back() != index)
+					list.matches.push_back(index);
+			});
+	}
+
+	for (uint32_t index : list.matches)
+		list.matched[index] = 1;
+}
+
+// Only entries matching the previous query can match a longer one, so typing narrows that set.
+static void SearchWithin(ImFileDialogSearchList& list, std::string_view query, bool fuzzy)
+{
+	size_t kept = 0;
+	for (uint32_t index : list.matches)
+	{
+		if (MatchSearch(list, index, query, fuzzy))
+			list.matches[kept++] = index;
+		else
+			list.matched[index] = 0;
+	}
+	list.matches.resize(kept);
+}
+
+static void SearchAppended(ImFileDialogSearchList& list, size_t firstIndex, std::string_view query, bool fuzzy)
+{
+	for (uint32_t i = (uint32_t)firstIndex; i + 1 < list.offsets.size(); ++i)
+	{
+		if (MatchSearch(list, i, query, fuzzy))
+		{
+			list.matched[i] = 1;
+			list.matches.push_back(i);
+		}
+	}
+}
+
+// Brings the search results in line with the query and the listing. Returns true when the
+// set of matching entries changed.
+static bool UpdateSearch(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->searchQuery.empty())
+	{
+		bool changed = dialogInfo->search && !dialogInfo->search->query.empty();
+		dialogInfo->search.reset();
+		return changed;
+	}
+
+	if (!dialogInfo->search)
+		dialogInfo->search = std::make_shared<ImFileDialogSearch>();
+
+	ImFileDialogSearch* search = dialogInfo->search.get();
+	std::string query = ToLower(dialogInfo->searchQuery);
+
+	size_t indexedFiles = search->files.matched.size();
+	size_t indexedDirectories = search->directories.matched.size();
+	IndexNames(search->files, dialogInfo->currentFiles);
+	IndexNames(search->directories, dialogInfo->currentDirectories);
+
+	if (query != search->query || dialogInfo->fuzzySearch != search->fuzzy)
+	{
+		bool narrowing = !search->query.empty() && dialogInfo->fuzzySearch == search->fuzzy && (search->fuzzy ? query.compare(0, search->query.size(), search->query) == 0 : query.find(search->query) != std::string::npos);
+
+		for (ImFileDialogSearchList* list : { &search->files, &search->directories })
+		{
+			if (narrowing)
+			{
+				size_t indexed = list == &search->files ? indexedFiles : indexedDirectories;
+				SearchWithin(*list, query, dialogInfo->fuzzySearch);
+				SearchAppended(*list, indexed, query, dialogInfo->fuzzySearch);
+			}
+			else
+			{
+				SearchAll(*list, query, dialogInfo->fuzzySearch);
+			}
+		}
+
+		search->query = query;
+		search->fuzzy = dialogInfo->fuzzySearch;
+		return true;
+	}
+
+	if (indexedFiles == dialogInfo->currentFiles.size() && indexedDirectories == dialogInfo->currentDirectories.size())
+		return false;
+
+	SearchAppended(search->files, indexedFiles, query, search->fuzzy);
+	SearchAppended(search->directories, indexedDirectories, query, search->fuzzy);
+	return true;
+}
+
+static std::string FormatDate(std::filesystem::file_time_type lastWriteTime)
+{
+	if (lastWriteTime == ImFileDialogEntryList::unknownTime)
+		return "-";
+
+	auto st = std::chrono::time_point_cast<std::chrono::system_clock::duration>(lastWriteTime - decltype(lastWriteTime)::clock::now() + std::chrono::system_clock::now());
+	std::time_t tt = std::chrono::system_clock::to_time_t(st);
+	std::tm mt;
+#ifdef _WIN32
+	localtime_s(&mt, &tt);
+#else
+	localtime_r(&tt, &mt);
+#endif
+	char buffer[32];
+	size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", &mt);
+	return std::string(buffer, length);
+}
+
+#ifdef _WIN32
+static const char* pathSeparators = "\\/";
+#else
+static const char* pathSeparators = "/";
+#endif
+
+// Appends the collation key of a name: ASCII letters lowercased, and each run of digits
+// replaced by '0', the digit count without leading zeros, then those digits. A longer number
+// thus sorts after a shorter one, and numbers of equal length compare digit by digit.
+static void AppendCollationKey(std::string& keys, std::string_view name)
+{
+	for (size_t i = 0; i < name.size();)
+	{
+		char c = name[i];
+		if (c < '0' || c > '9')
+		{
+			keys.push_back(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+			++i;
+			continue;
+		}
+
+		size_t end = i;
+		while (end < name.size() && name[end] >= '0' && name[end] <= '9')
+			++end;
+
+		while (i + 1 < end && name[i] == '0')
+			++i;
+
+		size_t digits = std::min<size_t>(end - i, 255);
+		keys.push_back('0');
+		keys.push_back((char)(uint8_t)digits);
+		keys.append(name.data() + i, digits);
+		i = end;
+	}
+}
+
+void ImFileDialogEntryList::push_back(std::string_view name, std::uintmax_t size, std::filesystem::file_time_type lastWriteTime, uint64_t filterMask)
+{
+	size_t separator = name.find_last_of(pathSeparators);
+	size_t fileNameStart = separator == std::string_view::npos ? 0 : separator + 1;
+	size_t dot = name.rfind('.');
+
+	// Same rule as ExtensionOf: a leading dot starts a hidden name, not an extension.
+	size_t extensionOffset = dot == std::string_view::npos || dot <= fileNameStart ? name.size() : dot;
+
+	nameOffsets.push_back((uint32_t)nameArena.size());
+	nameArena.append(name);
+	nameArena.push_back('\0');
+	keyOffsets.push_back((uint32_t)keyArena.size());
+	AppendCollationKey(keyArena, name);
+	extensionOffsets.push_back((uint16_t)extensionOffset);
+	sizes.push_back(size);
+	lastWriteTimes.push_back(lastWriteTime);
+	filterMasks.push_back(filterMask);
+	metadataFlags.push_back(1);
+}
+
+void ImFileDialogEntryList::push_back(std::string_view name, uint64_t filterMask)
+{
+	push_back(name, unknownSize, unknownTime, filterMask);
+	metadataFlags.back() = 0;
+	missingMetadata++;
+}
+
+// Appends the entries of `other` from index `first` on.
+void ImFileDialogEntryList::append(const ImFileDialogEntryList& other, size_t first)
+{
+	if (first >= other.size())
+		return;
+
+	uint32_t base = (uint32_t)nameArena.size();
+	uint32_t otherBase = other.nameOffsets[first];
+
+	nameArena.append(other.nameArena, otherBase, std::string::npos);
+	for (size_t i = first; i < other.nameOffsets.size(); ++i)
+		nameOffsets.push_back(base + other.nameOffsets[i] - otherBase);
+
+	uint32_t keyBase = (uint32_t)keyArena.size();
+	uint32_t otherKeyBase = other.keyOffsets[first];
+
+	keyArena.append(other.keyArena, otherKeyBase, std::string::npos);
+	for (size_t i = first; i < other.keyOffsets.size(); ++i)
+		keyOffsets.push_back(keyBase + other.keyOffsets[i] - otherKeyBase);
+
+	extensionOffsets.insert(extensionOffsets.end(), other.extensionOffsets.begin() + first, other.extensionOffsets.end());
+	sizes.insert(sizes.end(), other.sizes.begin() + first, other.sizes.end());
+	lastWriteTimes.insert(lastWriteTimes.end(), other.lastWriteTimes.begin() + first, other.lastWriteTimes.end());
+	filterMasks.insert(filterMasks.end(), other.filterMasks.begin() + first, other.filterMasks.end());
+	metadataFlags.insert(metadataFlags.end(), other.metadataFlags.begin() + first, other.metadataFlags.end());
+	missingMetadata += first == 0 ? other.missingMetadata : (size_t)std::count(other.metadataFlags.begin() + first, other.metadataFlags.end(), 0);
+}
+
+// Keeps the entries whose remap value is not UINT32_MAX, in order. Remap values must count up
+// from zero over the kept entries.
+void ImFileDialogEntryList::compact(const std::vector<uint32_t>& remap)
+{
+	std::string names;
+	names.reserve(nameArena.size());
+	std::string keys;
+	keys.reserve(keyArena.size());
+	size_t kept = 0;
+	missingMetadata = 0;
+
+	for (size_t i = 0; i < remap.size(); ++i)
+	{
+		if (remap[i] == UINT32_MAX)
+			continue;
+
+		std::string_view entryName = name(i);
+		nameOffsets[kept] = (uint32_t)names.size();
+		names.append(entryName);
+		names.push_back('\0');
+
+		std::string_view entryKey = collationKey(i);
+		keyOffsets[kept] = (uint32_t)keys.size();
+		keys.append(entryKey);
+
+		extensionOffsets[kept] = extensionOffsets[i];
+		sizes[kept] = sizes[i];
+		lastWriteTimes[kept] = lastWriteTimes[i];
+		filterMasks[kept] = filterMasks[i];
+		metadataFlags[kept] = metadataFlags[i];
+		missingMetadata += metadataFlags[i] ? 0 : 1;
+		kept++;
+	}
+
+	nameArena = std::move(names);
+	nameOffsets.resize(kept);
+	keyArena = std::move(keys);
+	keyOffsets.resize(kept);
+	extensionOffsets.resize(kept);
+	sizes.resize(kept);
+	lastWriteTimes.resize(kept);
+	filterMasks.resize(kept);
+	metadataFlags.resize(kept);
+}
+
+void ImFileDialogEntryList::clear()
+{
+	nameArena.clear();
+	nameOffsets.clear();
+	keyArena.clear();
+	keyOffsets.clear();
+	extensionOffsets.clear();
+	sizes.clear();
+	lastWriteTimes.clear();
+	filterMasks.clear();
+	metadataFlags.clear();
+	missingMetadata = 0;
+}
+
+size_t ImFileDialogEntryList::bytes() const
+{
+	return sizeof(ImFileDialogEntryList) + nameArena.capacity()
+		+ nameOffsets.capacity() * sizeof(uint32_t)
+		+ keyArena.capacity()
+		+ keyOffsets.capacity() * sizeof(uint32_t)
+		+ extensionOffsets.capacity() * sizeof(uint16_t)
+		+ sizes.capacity() * sizeof(std::uintmax_t)
+		+ lastWriteTimes.capacity() * sizeof(std::filesystem::file_time_type)
+		+ filterMasks.capacity() * sizeof(uint64_t)
+		+ metadataFlags.capacity();
+}
+
+void ImFileDialogSelection::set(size_t index, bool selected)
+{
+	if (contains(index) == selected)
+		return;
+
+	if (selected)
+		selectedCount++;
+	else
+		selectedCount--;
+
+	size_t word = index / 64;
+	uint64_t bit = uint64_t(1) << (index % 64);
+
+	if (selected != selectedByDefault(index))
+	{
+		if (word >= toggled.size())
+			toggled.resize(word + 1, 0);
+		toggled[word] |= bit;
+	}
+	else if (word < toggled.size())
+	{
+		toggled[word] &= ~bit;
+	}
+}
+
+// Follows a compaction of the listing; see ImFileDialogEntryList::compact.
+void ImFileDialogSelection::remap(const std::vector<uint32_t>& remap)
+{
+	std::vector<uint64_t> remapped;
+
+	size_t end = 0;
+	for (size_t i = 0; i < remap.size() && i < allSelectedEnd; ++i)
+		end += remap[i] != UINT32_MAX ? 1 : 0;
+
+	size_t count = 0;
+	for (size_t i = 0; i < remap.size(); ++i)
+		count += remap[i] != UINT32_MAX && contains(i) ? 1 : 0;
+
+	allSelectedEnd = end;
+	selectedCount = count;
+
+	for (size_t i = 0; i < remap.size() && i / 64 < toggled.size(); ++i)
+	{
+		if (remap[i] == UINT32_MAX || (toggled[i / 64] >> (i % 64) & 1) == 0)
+			continue;
+
+		if (remap[i] / 64 >= remapped.size())
+			remapped.resize(remap[i] / 64 + 1, 0);
+		remapped[remap[i] / 64] |= uint64_t(1) << (remap[i] % 64);
+	}
+
+	toggled = std::move(remapped);
+}
+
+std::string_view ImFileDialogEntryList::fileName(size_t index) const
+{
+	std::string_view entryName = name(index);
+	size_t separator = entryName.find_last_of(pathSeparators);
+	return separator == std::string_view::npos ? entryName : entryName.substr(separator + 1);
+}
+
+// The type comes with the directory listing; size and time are one metadata query each.
+// Returns false when either could not be read.
+static bool AddEntry(ImFileDialogEntryList& entries, const std::filesystem::directory_entry& entry, std::string_view name, bool isDirectory, uint64_t filterMask, uint64_t& filesystemCalls)
+{
+	std::error_code error;
+	std::uintmax_t size = ImFileDialogEntryList::unknownSize;
+	bool read = true;
+
+	if (!isDirectory)
+	{
+		size = entry.file_size(error);
+		if (error)
+		{
+			size = ImFileDialogEntryList::unknownSize;
+			read = false;
+		}
+		filesystemCalls++;
+	}
+
+	std::filesystem::file_time_type lastWriteTime = entry.last_write_time(error);
+	if (error)
+	{
+		lastWriteTime = ImFileDialogEntryList::unknownTime;
+		read = false;
+	}
+	filesystemCalls++;
+
+	entries.push_back(name, size, lastWriteTime, filterMask);
+	return read;
+}
+
+#ifdef IMGUI_FILEDIALOG_READDIR
+// Lists names straight from readdir and calls `visit(name, isDirectory)` until it returns false.
+// The entry type answers the directory question; only symlinks and unknown types need a stat.
+// The directory open itself is left for the caller to count.
+template <typename Visit>
+static void ReadDirectoryNames(const std::filesystem::path& directoryPath, uint64_t& filesystemCalls, std::error_code& error, Visit visit)
+{
+	DIR* directory = opendir(directoryPath.c_str());
+
+	if (!directory)
+	{
+		error = std::error_code(errno, std::generic_category());
+		return;
+	}
+
+	int directoryFd = dirfd(directory);
+	for (;;)
+	{
+		errno = 0;
+		dirent* entry = readdir(directory);
+		if (!entry)
+		{
+			if (errno != 0)
+				error = std::error_code(errno, std::generic_category());
+			break;
+		}
+
+		const char* name = entry->d_name;
+		if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+			continue;
+
+		bool isDirectory = entry->d_type == DT_DIR;
+		if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK)
+		{
+			struct stat status;
+			isDirectory = fstatat(directoryFd, name, &status, 0) == 0 && S_ISDIR(status.st_mode);
+			filesystemCalls++;
+		}
+
+		if (!visit(std::string_view(name), isDirectory))
+			break;
+	}
+
+	closedir(directory);
+}
+
+// C++17 has no conversion between file_time_type and the system clock, so the offset between
+// the two is measured once; every converted time is shifted by the same amount.
+static std::filesystem::file_time_type ToFileTime(const timespec& time)
+{
+	using FileDuration = std::filesystem::file_time_type::duration;
+	static const FileDuration offset = std::filesystem::file_time_type::clock::now().time_since_epoch()
+		- std::chrono::duration_cast<FileDuration>(std::chrono::system_clock::now().time_since_epoch());
+
+	auto sinceEpoch = std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+	return std::filesystem::file_time_type(std::chrono::duration_cast<FileDuration>(sinceEpoch) + offset);
+}
+#endif
+
+static std::string FormatSize(std::uintmax_t size)
+{
+	return size == ImFileDialogEntryList::unknownSize ? "-" : std::to_string(size);
+}
+
+static void RunWorker(std::shared_ptr<ImFileDialogService> service)
+{
+	ImFileDialogWorkerPool& pool = service->pool;
+	std::unique_lock<std::mutex> lock(pool.mutex);
+
+	// Idle threads wait a while for more work and then exit, so a quiet service holds none.
+	for (;;)
+	{
+		pool.idleThreads++;
+		bool hasTask = pool.wake.wait_for(lock, poolIdleTimeout, [&]() { return !pool.tasks.empty(); });
+		pool.idleThreads--;
+
+		if (!hasTask)
+			break;
+
+		std::function<void()> task = std::move(pool.tasks.front());
+		pool.tasks.pop_front();
+		lock.unlock();
+		task();
+		lock.lock();
+	}
+
+	pool.threads--;
+}
+
+static void SubmitTask(const std::shared_ptr<ImFileDialogService>& service, std::function<void()> task)
+{
+	ImFileDialogWorkerPool& pool = service->pool;
+	std::lock_guard<std::mutex> lock(pool.mutex);
+
+	pool.tasks.push_back(std::move(task));
+	if (pool.tasks.size() > pool.idleThreads && pool.threads < poolMaxThreads + std::min(pool.stalledThreads, poolMaxStalledThreads))
+	{
+		pool.threads++;
+		std::thread(RunWorker, service).detach();
+	}
+	pool.wake.notify_one();
+}
+
+// Dialogs without a service of their own share one for the whole process.
+static const std::shared_ptr<ImFileDialogService>& ServiceOf(ImFileDialogInfo* dialogInfo)
+{
+	if (!dialogInfo->service)
+	{
+		static const std::shared_ptr<ImFileDialogService> shared = std::make_shared<ImFileDialogService>();
+		dialogInfo->service = shared;
+	}
+
+	return dialogInfo->service;
+}
+
+// Serves metadata requests until both queues are empty. Each task holds the directory open and
+// queries entries relative to it, one stat per entry for both size and time.
+static void FetchMetadata(std::shared_ptr<ImFileDialogMetadata> metadata)
+{
+#ifdef IMGUI_FILEDIALOG_READDIR
+	int directoryFd = open(metadata->directoryPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	metadata->filesystemCalls++;
+#endif
+
+	std::unique_lock<std::mutex> lock(metadata->mutex);
+	while (!metadata->cancelled && (!metadata->visible.empty() || !metadata->bulk.empty()))
+	{
+		// The request is kept in `running` while it is served, so a change to the listing can
+		// point it at its entry's new index.
+		std::deque<ImFileDialogMetadataRequest>& queue = !metadata->visible.empty() ? metadata->visible : metadata->bulk;
+		auto running = metadata->running.insert(metadata->running.end(), std::move(queue.front()));
+		queue.pop_front();
+		const ImFileDialogMetadataRequest& request = *running;
+		ImFileDialogMetadataResult result = { request.isDirectory, request.index, ImFileDialogEntryList::unknownSize, ImFileDialogEntryList::unknownTime };
+		lock.unlock();
+
+#ifdef IMGUI_FILEDIALOG_READDIR
+		struct stat status;
+		if (directoryFd >= 0 && fstatat(directoryFd, request.name.c_str(), &status, 0) == 0)
+		{
+			if (!request.isDirectory)
+				result.size = (std::uintmax_t)status.st_size;
+#ifdef __APPLE__
+			result.lastWriteTime = ToFileTime(status.st_mtimespec);
+#else
+			result.lastWriteTime = ToFileTime(status.st_mtim);
+#endif
+		}
+		metadata->filesystemCalls++;
+#else
+		std::error_code error;
+		std::filesystem::path path = metadata->directoryPath / request.name;
+		if (!request.isDirectory)
+		{
+			result.size = std::filesystem::file_size(path, error);
+			if (error)
+				result.size = ImFileDialogEntryList::unknownSize;
+			metadata->filesystemCalls++;
+		}
+
+		result.lastWriteTime = std::filesystem::last_write_time(path, error);
+		if (error)
+			result.lastWriteTime = ImFileDialogEntryList::unknownTime;
+		metadata->filesystemCalls++;
+#endif
+
+		lock.lock();
+		result.index = running->index;
+		metadata->running.erase(running);
+		metadata->results.push_back(result);
+	}
+
+	metadata->workers--;
+	lock.unlock();
+
+#ifdef IMGUI_FILEDIALOG_READDIR
+	if (directoryFd >= 0)
+		close(directoryFd);
+#endif
+}
+
+static void CancelMetadata(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->metadata)
+	{
+		dialogInfo->metadata->cancelled = true;
+		dialogInfo->metadata.reset();
+	}
+}
+
+static ImFileDialogMetadata* GetMetadata(ImFileDialogInfo* dialogInfo)
+{
+	if (!dialogInfo->metadata)
+	{
+		dialogInfo->metadata = std::make_shared<ImFileDialogMetadata>();
+		dialogInfo->metadata->directoryPath = dialogInfo->scannedPath;
+	}
+
+	return dialogInfo->metadata.get();
+}
+
+// Starts pool tasks for the queued requests, up to metadataMaxWorkers at a time. Called with the
+// metadata mutex held.
+static void StartMetadataWorkers(ImFileDialogInfo* dialogInfo)
+{
+	ImFileDialogMetadata* metadata = dialogInfo->metadata.get();
+	size_t queued = metadata->visible.size() + metadata->bulk.size();
+
+	while (metadata->workers < metadataMaxWorkers && metadata->workers < queued)
+	{
+		metadata->workers++;
+		SubmitTask(ServiceOf(dialogInfo), [metadata = dialogInfo->metadata]() { FetchMetadata(metadata); });
+	}
+}
+
+// Replaces the visible queue with the rows drawn this frame, so rows scrolled past are dropped.
+static void RequestVisibleMetadata(ImFileDialogInfo* dialogInfo, std::deque<ImFileDialogMetadataRequest>& requests)
+{
+	if (requests.empty() && !dialogInfo->metadata)
+		return;
+
+	ImFileDialogMetadata* metadata = GetMetadata(dialogInfo);
+	std::lock_guard<std::mutex> lock(metadata->mutex);
+	metadata->visible.swap(requests);
+	StartMetadataWorkers(dialogInfo);
+}
+
+static void QueueBulkMetadata(std::deque<ImFileDialogMetadataRequest>& bulk, const ImFileDialogEntryList& entries, bool isDirectory, size_t& queued)
+{
+	for (; queued < entries.size(); ++queued)
+	{
+		if (!entries.hasMetadata(queued))
+			bulk.push_back({ isDirectory, (uint32_t)queued, std::string(entries.name(queued)) });
+	}
+}
+
+// Sorting by size or date needs every entry; queues whatever has not been queued yet.
+static void RequestAllMetadata(ImFileDialogInfo* dialogInfo)
+{
+	ImFileDialogMetadata* metadata = GetMetadata(dialogInfo);
+	std::lock_guard<std::mutex> lock(metadata->mutex);
+	QueueBulkMetadata(metadata->bulk, dialogInfo->currentDirectories, true, metadata->bulkDirectories);
+	QueueBulkMetadata(metadata->bulk, dialogInfo->currentFiles, false, metadata->bulkFiles);
+	StartMetadataWorkers(dialogInfo);
+}
+
+static void ConsumeMetadata(ImFileDialogInfo* dialogInfo)
+{
+	ImFileDialogMetadata* metadata = dialogInfo->metadata.get();
+	std::lock_guard<std::mutex> lock(metadata->mutex);
+
+	dialogInfo->stats.frame.filesystemCalls += metadata->filesystemCalls.exchange(0);
+
+	for (const ImFileDialogMetadataResult& result : metadata->results)
+	{
+		ImFileDialogEntryList& entries = result.isDirectory ? dialogInfo->currentDirectories : dialogInfo->currentFiles;
+		// A folder's size column may already hold its measured size.
+		if (result.index < entries.size())
+			entries.setMetadata(result.index, result.isDirectory ? entries.fileSize(result.index) : result.size, result.lastWriteTime);
+	}
+
+	metadata->sortStale |= !metadata->results.empty();
+	metadata->results.clear();
+}
+
+// Adds up the sizes of every regular file below `root` without following symlinks. Files with
+// several hard links are counted once, by device and inode.
+static std::uintmax_t MeasureFolder(const std::filesystem::path& root, const std::atomic<bool>& cancelled, uint64_t& filesystemCalls)
+{
+	std::uintmax_t total = 0;
+	std::set<std::pair<uint64_t, uint64_t>> linkedFiles;
+
+#ifdef _WIN32
+	std::error_code error;
+	std::filesystem::recursive_directory_iterator iterator(root, std::filesystem::directory_options::skip_permission_denied, error);
+	std::filesystem::recursive_directory_iterator end;
+	filesystemCalls++;
+
+	for (; !error && iterator != end && !cancelled; iterator.increment(error))
+	{
+		const std::filesystem::directory_entry& entry = *iterator;
+		std::error_code entryError;
+		if (!entry.is_regular_file(entryError) || entry.is_symlink(entryError))
+			continue;
+
+		if (entry.hard_link_count(entryError) > 1)
+		{
+			HANDLE handle = CreateFileW(entry.path().c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+			BY_HANDLE_FILE_INFORMATION information;
+			bool known = handle != INVALID_HANDLE_VALUE && GetFileInformationByHandle(handle, &information);
+			if (handle != INVALID_HANDLE_VALUE)
+				CloseHandle(handle);
+			filesystemCalls++;
+
+			if (known && !linkedFiles.insert({ information.dwVolumeSerialNumber, (uint64_t)information.nFileIndexHigh << 32 | information.nFileIndexLow }).second)
+				continue;
+		}
+
+		std::uintmax_t size = entry.file_size(entryError);
+		if (!entryError)
+			total += size;
+	}
+#else
+	std::vector<std::filesystem::path> pending = { root };
+	while (!pending.empty() && !cancelled)
+	{
+		std::filesystem::path directoryPath = std::move(pending.back());
+		pending.pop_back();
+
+		DIR* directory = opendir(directoryPath.c_str());
+		filesystemCalls++;
+		if (!directory)
+			continue;
+
+		int directoryFd = dirfd(directory);
+		while (dirent* entry = readdir(directory))
+		{
+			if (cancelled)
+				break;
+
+			const char* name = entry->d_name;
+			if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+				continue;
+
+#ifdef IMGUI_FILEDIALOG_READDIR
+			if (entry->d_type == DT_DIR)
+			{
+				pending.push_back(directoryPath / name);
+				continue;
+			}
+#endif
+
+			struct stat status;
+			filesystemCalls++;
+			if (fstatat(directoryFd, name, &status, AT_SYMLINK_NOFOLLOW) != 0)
+				continue;
+
+			if (S_ISDIR(status.st_mode))
+				pending.push_back(directoryPath / name);
+			else if (S_ISREG(status.st_mode) && (status.st_nlink <= 1 || linkedFiles.insert({ (uint64_t)status.st_dev, (uint64_t)status.st_ino }).second))
+				total += (std::uintmax_t)status.st_size;
+		}
+
+		closedir(directory);
+	}
+#endif
+
+	return total;
+}
+
+// Measures queued folders until none are left, serving them from the service's cache when the
+// folder has not been written since.
+static void FetchFolderSizes(std::shared_ptr<ImFileDialogFolderSizes> folderSizes, std::shared_ptr<ImFileDialogService> service)
+{
+	std::unique_lock<std::mutex> lock(folderSizes->mutex);
+	while (!folderSizes->cancelled && !folderSizes->requests.empty())
+	{
+		// Kept in `running` while measured, like a metadata request.
+		auto running = folderSizes->running.insert(folderSizes->running.end(), std::move(folderSizes->requests.front()));
+		folderSizes->requests.pop_front();
+		const ImFileDialogFolderSizeRequest& request = *running;
+		lock.unlock();
+
+		uint64_t filesystemCalls = 1;
+		std::filesystem::path path = folderSizes->directoryPath / request.name;
+		std::error_code error;
+		std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(path, error);
+		std::uintmax_t size = ImFileDialogEntryList::unknownSize;
+
+		if (!error)
+		{
+			std::lock_guard<std::mutex> serviceLock(service->mutex);
+			auto it = service->folderSizes.find(path.native());
+			if (it != service->folderSizes.end() && it->second.lastWriteTime == lastWriteTime)
+				size = it->second.size;
+		}
+
+		if (!error && size == ImFileDialogEntryList::unknownSize)
+		{
+			size = MeasureFolder(path, folderSizes->cancelled, filesystemCalls);
+
+			if (!folderSizes->cancelled)
+			{
+				std::lock_guard<std::mutex> serviceLock(service->mutex);
+				if (service->folderSizes.size() >= folderSizeCacheMaxEntries)
+					service->folderSizes.clear();
+				service->folderSizes[path.native()] = { lastWriteTime, size };
+			}
+		}
+
+		folderSizes->filesystemCalls += filesystemCalls;
+
+		lock.lock();
+		uint32_t index = running->index;
+		folderSizes->running.erase(running);
+		if (!folderSizes->cancelled)
+			folderSizes->results.push_back({ index, size });
+	}
+
+	folderSizes->workers--;
+}
+
+static void CancelFolderSizes(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->folderSizes)
+	{
+		dialogInfo->folderSizes->cancelled = true;
+		dialogInfo->folderSizes.reset();
+	}
+}
+
+// Queues every listed folder without a size, then applies the sizes measured so far. A run
+// cancelled from the UI stays cancelled until the listing changes.
+static void UpdateFolderSizes(ImFileDialogInfo* dialogInfo)
+{
+	if (!dialogInfo->showFolderSizes || dialogInfo->walk)
+	{
+		CancelFolderSizes(dialogInfo);
+		return;
+	}
+
+	if (!dialogInfo->folderSizes)
+	{
+		dialogInfo->folderSizes = std::make_shared<ImFileDialogFolderSizes>();
+		dialogInfo->folderSizes->directoryPath = dialogInfo->scannedPath;
+	}
+
+	ImFileDialogFolderSizes* folderSizes = dialogInfo->folderSizes.get();
+	ImFileDialogEntryList& directories = dialogInfo->currentDirectories;
+	if (folderSizes->cancelled)
+		return;
+
+	std::lock_guard<std::mutex> lock(folderSizes->mutex);
+
+	for (; folderSizes->queued < directories.size(); ++folderSizes->queued)
+	{
+		if (directories.fileSize(folderSizes->queued) != ImFileDialogEntryList::unknownSize)
+			continue;
+
+		folderSizes->requests.push_back({ (uint32_t)folderSizes->queued, std::string(directories.name(folderSizes->queued)) });
+		folderSizes->pending++;
+	}
+
+	while (folderSizes->workers < folderSizeMaxWorkers && folderSizes->workers < folderSizes->requests.size())
+	{
+		folderSizes->workers++;
+		SubmitTask(ServiceOf(dialogInfo), [folderSizes = dialogInfo->folderSizes, service = ServiceOf(dialogInfo)]() { FetchFolderSizes(folderSizes, service); });
+	}
+
+	dialogInfo->stats.frame.filesystemCalls += folderSizes->filesystemCalls.exchange(0);
+
+	for (const ImFileDialogFolderSizeResult& result : folderSizes->results)
+	{
+		if (result.index < directories.size())
+			directories.setFileSize(result.index, result.size);
+		folderSizes->pending--;
+	}
+
+	folderSizes->sortStale |= !folderSizes->results.empty();
+	folderSizes->results.clear();
+}
+
+// A header cell of the browser table, which sorts by its column when clicked. TableHeader also
+// opens the table's context menu on right-click, where extra columns are hidden.
+static bool DrawHeaderCell(const char* label)
+{
+	if (!ImGui::TableNextColumn())
+		return false;
+
+	ImGui::TableHeader(label);
+	return ImGui::IsItemClicked(ImGuiMouseButton_Left);
+}
+
+static void ClearColumnSortOrders(ImFileDialogInfo* dialogInfo)
+{
+	for (ImFileDialogColumn& column : dialogInfo->columns)
+		column.sortOrder = ImGuiFileDialogSortOrder_None;
+}
+
+static ImFileDialogColumnEntry MakeColumnEntry(const ImFileDialogInfo* dialogInfo, const ImFileDialogEntryList& entries, size_t index, bool isDirectory)
+{
+	ImFileDialogColumnEntry entry;
+	entry.path = entries.path(dialogInfo->directoryPath, index);
+	entry.isDirectory = isDirectory;
+	entry.size = entries.fileSize(index);
+	entry.lastWriteTime = entries.lastWriteTime(index);
+	return entry;
+}
+
+// Computes expensive column values, rows on screen first. A value is taken from the service cache
+// when the entry has not been written since it was computed.
+static void ComputeColumnValues(std::shared_ptr<ImFileDialogColumnValues> values, std::shared_ptr<ImFileDialogService> service)
+{
+	std::unique_lock<std::mutex> lock(values->mutex);
+	while (!values->cancelled && (!values->visible.empty() || !values->bulk.empty()))
+	{
+		// Kept in `running` while computed, like a metadata request.
+		std::deque<ImFileDialogColumnRequest>& queue = !values->visible.empty() ? values->visible : values->bulk;
+		auto running = values->running.insert(values->running.end(), std::move(queue.front()));
+		queue.pop_front();
+		ImFileDialogColumnRequest& request = *running;
+		ImFileDialogColumnResult result = { request.column, request.isDirectory, request.bulk, request.index, std::string() };
+		lock.unlock();
+
+		ImFileDialogColumnEntry& entry = request.entry;
+		if (entry.lastWriteTime == ImFileDialogEntryList::unknownTime)
+		{
+			std::error_code error;
+			entry.lastWriteTime = std::filesystem::last_write_time(entry.path, error);
+			if (error)
+				entry.lastWriteTime = ImFileDialogEntryList::unknownTime;
+			values->filesystemCalls++;
+		}
+
+		std::string key = values->cacheKeys[request.column];
+		key += '\0';
+		key += entry.path.u8string();
+
+		bool cached = false;
+
+		if (entry.lastWriteTime != ImFileDialogEntryList::unknownTime)
+		{
+			std::lock_guard<std::mutex> serviceLock(service->mutex);
+			auto it = service->columnValues.find(key);
+			if (it != service->columnValues.end() && it->second.lastWriteTime == entry.lastWriteTime)
+			{
+				result.value = it->second.value;
+				cached = true;
+			}
+		}
+
+		if (!cached)
+		{
+			result.value = values->providers[request.column](entry);
+
+			if (entry.lastWriteTime != ImFileDialogEntryList::unknownTime)
+			{
+				std::lock_guard<std::mutex> serviceLock(service->mutex);
+				if (service->columnValues.size() >= columnCacheMaxEntries)
+					service->columnValues.clear();
+				service->columnValues[key] = { entry.lastWriteTime, result.value };
+			}
+		}
+
+		lock.lock();
+		result.index = running->index;
+		values->running.erase(running);
+		if (!values->cancelled)
+			values->results.push_back(std::move(result));
+	}
+
+	values->workers--;
+}
+
+static void CancelColumnValues(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->columnValues)
+	{
+		dialogInfo->columnValues->cancelled = true;
+		dialogInfo->columnValues.reset();
+	}
+}
+
+// Starts pool tasks for the queued requests, up to columnMaxWorkers at a time. Called with the
+// values mutex held.
+static void StartColumnWorkers(ImFileDialogInfo* dialogInfo)
+{
+	ImFileDialogColumnValues* values = dialogInfo->columnValues.get();
+	size_t queued = values->visible.size() + values->bulk.size();
+
+	while (values->workers < columnMaxWorkers && values->workers < queued)
+	{
+		values->workers++;
+		SubmitTask(ServiceOf(dialogInfo), [values = dialogInfo->columnValues, service = ServiceOf(dialogInfo)]() { ComputeColumnValues(values, service); });
+	}
+}
+
+// The key of a column's values in the service cache: its cacheKey, or else the dialog and the
+// column's position, so that columns merely sharing a name never share values.
+static std::string ColumnCacheKey(ImFileDialogInfo* dialogInfo, size_t column)
+{
+	const std::string& cacheKey = dialogInfo->columns[column].cacheKey;
+	if (!cacheKey.empty())
+		return "key " + cacheKey;
+
+	static std::atomic<uint64_t> nextId{ 0 };
+	if (dialogInfo->columnCacheId == 0)
+		dialogInfo->columnCacheId = ++nextId;
+
+	return "dialog " + std::to_string(dialogInfo->columnCacheId) + " column " + std::to_string(column);
+}
+
+// Applies the values computed so far. Values are only kept for expensive columns of the folder
+// listing, and start over when the columns change.
+static void UpdateColumnValues(ImFileDialogInfo* dialogInfo)
+{
+	const std::vector<ImFileDialogColumn>& columns = dialogInfo->columns;
+	bool expensive = std::any_of(columns.begin(), columns.end(), [](const ImFileDialogColumn& column) { return column.cost == ImGuiFileDialogColumnCost_Expensive && column.value; });
+	if (!expensive || dialogInfo->walk)
+	{
+		CancelColumnValues(dialogInfo);
+		return;
+	}
+
+	ImFileDialogColumnValues* values = dialogInfo->columnValues.get();
+	bool changed = !values || values->names.size() != columns.size();
+	for (size_t i = 0; !changed && i < columns.size(); ++i)
+		changed = values->names[i] != columns[i].name || values->cacheKeys[i] != ColumnCacheKey(dialogInfo, i) || (bool)values->providers[i] != (columns[i].cost == ImGuiFileDialogColumnCost_Expensive && columns[i].value);
+
+	if (changed)
+	{
+		CancelColumnValues(dialogInfo);
+		dialogInfo->columnValues = std::make_shared<ImFileDialogColumnValues>();
+		values = dialogInfo->columnValues.get();
+		values->cells.resize(columns.size());
+
+		for (size_t i = 0; i < columns.size(); ++i)
+		{
+			values->names.push_back(columns[i].name);
+			values->cacheKeys.push_back(ColumnCacheKey(dialogInfo, i));
+			values->providers.push_back(columns[i].cost == ImGuiFileDialogColumnCost_Expensive ? columns[i].value : nullptr);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(values->mutex);
+
+	dialogInfo->stats.frame.filesystemCalls += values->filesystemCalls.exchange(0);
+
+	for (ImFileDialogColumnResult& result : values->results)
+	{
+		ImFileDialogColumnCells& cells = values->cells[result.column];
+		const ImFileDialogEntryList& entries = result.isDirectory ? dialogInfo->currentDirectories : dialogInfo->currentFiles;
+		if (result.index < entries.size())
+			(result.isDirectory ? cells.directories : cells.files)[result.index] = std::move(result.value);
+		if (result.bulk)
+			cells.pending--;
+	}
+
+	values->sortStale |= !values->results.empty();
+	values->results.clear();
+}
+
+// Replaces the visible queue with the cells drawn this frame, so rows scrolled past are dropped.
+static void RequestVisibleColumnValues(ImFileDialogInfo* dialogInfo, std::deque<ImFileDialogColumnRequest>& requests)
+{
+	if (!dialogInfo->columnValues)
+		return;
+
+	ImFileDialogColumnValues* values = dialogInfo->columnValues.get();
+	std::lock_guard<std::mutex> lock(values->mutex);
+	values->visible.swap(requests);
+	StartColumnWorkers(dialogInfo);
+}
+
+static void QueueBulkColumnValues(ImFileDialogInfo* dialogInfo, uint32_t column, const ImFileDialogEntryList& entries, bool isDirectory, size_t& queued)
+{
+	ImFileDialogColumnValues* values = dialogInfo->columnValues.get();
+	ImFileDialogColumnCells& cells = values->cells[column];
+	const std::unordered_map<uint32_t, std::string>& computed = isDirectory ? cells.directories : cells.files;
+
+	for (; queued < entries.size(); ++queued)
+	{
+		if (computed.count((uint32_t)queued) != 0)
+			continue;
+
+		values->bulk.push_back({ column, isDirectory, true, (uint32_t)queued, MakeColumnEntry(dialogInfo, entries, queued, isDirectory) });
+		cells.pending++;
+	}
+}
+
+// Sorting by an expensive column needs every value; queues whatever has not been queued yet.
+// Returns false once every value has arrived.
+static bool RequestAllColumnValues(ImFileDialogInfo* dialogInfo, size_t column)
+{
+	ImFileDialogColumnValues* values = dialogInfo->columnValues.get();
+	ImFileDialogColumnCells& cells = values->cells[column];
+
+	if (cells.bulkFiles < dialogInfo->currentFiles.size() || cells.bulkDirectories < dialogInfo->currentDirectories.size())
+	{
+		std::lock_guard<std::mutex> lock(values->mutex);
+		QueueBulkColumnValues(dialogInfo, (uint32_t)column, dialogInfo->currentDirectories, true, cells.bulkDirectories);
+		QueueBulkColumnValues(dialogInfo, (uint32_t)column, dialogInfo->currentFiles, false, cells.bulkFiles);
+		StartColumnWorkers(dialogInfo);
+	}
+
+	return cells.pending != 0;
+}
+
+// The text of every entry in an extra column, to sort by. Expensive values that have not
+// arrived yet sort as empty.
+static void ColumnSortValues(const ImFileDialogInfo* dialogInfo, size_t column, const ImFileDialogEntryList& entries, bool isDirectory, std::vector<std::string>& values)
+{
+	const ImFileDialogColumn& provider = dialogInfo->columns[column];
+	values.assign(entries.size(), std::string());
+
+	if (!provider.value)
+		return;
+
+	if (provider.cost == ImGuiFileDialogColumnCost_Cheap)
+	{
+		for (size_t i = 0; i < entries.size(); ++i)
+			values[i] = provider.value(MakeColumnEntry(dialogInfo, entries, i, isDirectory));
+		return;
+	}
+
+	if (!dialogInfo->columnValues)
+		return;
+
+	const ImFileDialogColumnCells& cells = dialogInfo->columnValues->cells[column];
+	for (const auto& cell : isDirectory ? cells.directories : cells.files)
+	{
+		if (cell.first < values.size())
+			values[cell.first] = cell.second;
+	}
+}
+
+// Draws the extra columns of one row. Hidden columns are skipped, and expensive values missing
+// from the row are requested.
+static void DrawColumnValues(ImFileDialogInfo* dialogInfo, const ImFileDialogEntryList& entries, size_t index, bool isDirectory, std::deque<ImFileDialogColumnRequest>& requests)
+{
+	for (size_t column = 0; column < dialogInfo->columns.size(); ++column)
+	{
+		if (!ImGui::TableNextColumn())
+			continue;
+
+		const ImFileDialogColumn& provider = dialogInfo->columns[column];
+		if (!provider.value)
+		{
+			ImGui::TextUnformatted("-");
+		}
+		else if (provider.cost == ImGuiFileDialogColumnCost_Cheap)
+		{
+			std::string value = provider.value(MakeColumnEntry(dialogInfo, entries, index, isDirectory));
+			ImGui::TextUnformatted(value.c_str());
+		}
+		else if (!dialogInfo->columnValues)
+		{
+			// Subtree search results are not computed.
+			ImGui::TextUnformatted("-");
+		}
+		else
+		{
+			const ImFileDialogColumnCells& cells = dialogInfo->columnValues->cells[column];
+			const std::unordered_map<uint32_t, std::string>& computed = isDirectory ? cells.directories : cells.files;
+			auto it = computed.find((uint32_t)index);
+
+			if (it != computed.end())
+			{
+				ImGui::TextUnformatted(it->second.c_str());
+			}
+			else
+			{
+				ImGui::TextUnformatted("...");
+				requests.push_back({ (uint32_t)column, isDirectory, false, (uint32_t)index, MakeColumnEntry(dialogInfo, entries, index, isDirectory) });
+			}
+		}
+	}
+}
+
+static void CancelScan(ImFileDialogInfo* dialogInfo)
+{
+	dialogInfo->scan.reset();
+}
+
+// A listing read with lazyMetadata may lack sizes and times, so it only serves lazy dialogs.
+static bool SameListing(const ImFileDialogListing& listing, const std::filesystem::path& directoryPath, ImGuiFileDialogType type, uint64_t filtersFingerprint, bool lazyMetadata)
+{
+	return listing.directoryPath == directoryPath && listing.type == type && listing.filtersFingerprint == filtersFingerprint && listing.lazyMetadata == lazyMetadata;
+}
+
+// Replaces any cached listing of the same directory, then evicts the least recently used ones.
+static void InsertListing(ImFileDialogService* service, ImFileDialogListing listing, size_t maxListings, size_t maxBytes)
+{
+	listing.bytes = sizeof(ImFileDialogListing) + listing.files.bytes() + listing.directories.bytes();
+
+	std::lock_guard<std::mutex> lock(service->mutex);
+	ImFileDialogCache* cache = &service->cache;
+
+	for (auto it = cache->listings.begin(); it != cache->listings.end(); ++it)
+	{
+		if (SameListing(*it, listing.directoryPath, listing.type, listing.filtersFingerprint, listing.lazyMetadata))
+		{
+			cache->bytes -= it->bytes;
+			cache->listings.erase(it);
+			break;
+		}
+	}
+
+	cache->bytes += listing.bytes;
+	cache->listings.push_front(std::move(listing));
+
+	while (!cache->listings.empty() && (cache->listings.size() > maxListings || cache->bytes > maxBytes))
+	{
+		cache->bytes -= cache->listings.back().bytes;
+		cache->listings.pop_back();
+	}
+}
+
+// Puts the listing on screen at the front of the shared LRU cache, moving it out of the dialog
+// or, with `keep`, copying it. Only complete listings are kept.
+static void StoreListing(ImFileDialogInfo* dialogInfo, bool keep = false)
+{
+	if (dialogInfo->scannedPath.empty() || dialogInfo->listDirectory || (dialogInfo->scan && (!dialogInfo->scan->finished || dialogInfo->scan->error)))
+		return;
+
+	// A copy that would be evicted straight away is not worth making.
+	if (keep && dialogInfo->currentFiles.bytes() + dialogInfo->currentDirectories.bytes() > dialogInfo->cacheMaxBytes)
+		return;
+
+	ImFileDialogListing listing;
+	listing.directoryPath = dialogInfo->scannedPath;
+	listing.lastWriteTime = dialogInfo->scannedWriteTime;
+	listing.type = dialogInfo->type;
+	listing.filtersFingerprint = FiltersFingerprint(dialogInfo->parsedFilters);
+	listing.lazyMetadata = dialogInfo->lazyMetadata;
+
+	if (keep)
+	{
+		listing.files = dialogInfo->currentFiles;
+		listing.directories = dialogInfo->currentDirectories;
+	}
+	else
+	{
+		listing.files = std::move(dialogInfo->currentFiles);
+		listing.directories = std::move(dialogInfo->currentDirectories);
+		dialogInfo->currentFiles.clear();
+		dialogInfo->currentDirectories.clear();
+	}
+
+	InsertListing(ServiceOf(dialogInfo).get(), std::move(listing), dialogInfo->cacheMaxListings, dialogInfo->cacheMaxBytes);
+}
+
+static void ClearSelection(ImFileDialogInfo* dialogInfo)
+{
+	dialogInfo->selection.clear();
+	dialogInfo->selectedCount = 0;
+}
+
+// Reads whether the path exists and is a folder or a file, and a folder's write time, on the
+// worker pool.
+static std::shared_ptr<ImFileDialogPathCheck> StartPathCheck(ImFileDialogInfo* dialogInfo, const std::filesystem::path& path)
+{
+	auto check = std::make_shared<ImFileDialogPathCheck>();
+	check->path = path;
+	dialogInfo->stats.frame.filesystemCalls++;
+
+	SubmitTask(ServiceOf(dialogInfo), [check]()
+		{
+			std::filesystem::file_status status = std::filesystem::status(check->path, check->error);
+			check->exists = std::filesystem::exists(status);
+			check->isDirectory = std::filesystem::is_directory(status);
+			check->isRegularFile = std::filesystem::is_regular_file(status);
+			if (check->isDirectory)
+				check->lastWriteTime = std::filesystem::last_write_time(check->path, check->error);
+			check->finished = true;
+		});
+
+	return check;
+}
+
+// Serves directoryPath from the cache. The folder's write time is read on a worker, and the
+// dialog rescans once it turns out the folder was modified since it was listed. The listing
+// stays cached for other dialogs; this one gets a copy.
+static bool LoadListing(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->listDirectory)
+		return false;
+
+	ImFileDialogService* service = ServiceOf(dialogInfo).get();
+	uint64_t filtersFingerprint = FiltersFingerprint(dialogInfo->parsedFilters);
+	std::lock_guard<std::mutex> lock(service->mutex);
+	ImFileDialogCache* cache = &service->cache;
+
+	for (auto it = cache->listings.begin(); it != cache->listings.end(); ++it)
+	{
+		if (!SameListing(*it, dialogInfo->directoryPath, dialogInfo->type, filtersFingerprint, dialogInfo->lazyMetadata))
+			continue;
+
+		CancelScan(dialogInfo);
+
+		dialogInfo->scannedPath = it->directoryPath;
+		dialogInfo->scannedWriteTime = it->lastWriteTime;
+		dialogInfo->refreshInfo = false;
+		dialogInfo->refreshSort = true;
+		dialogInfo->currentIndex = 0;
+		dialogInfo->currentFiles = it->files;
+		dialogInfo->currentDirectories = it->directories;
+		dialogInfo->search.reset();
+		ClearSelection(dialogInfo);
+		CancelMetadata(dialogInfo);
+		CancelFolderSizes(dialogInfo);
+		CancelColumnValues(dialogInfo);
+		dialogInfo->listingCheck = StartPathCheck(dialogInfo, it->directoryPath);
+
+		cache->listings.splice(cache->listings.begin(), cache->listings, it);
+		return true;
+	}
+
+	return false;
+}
+
+static void FlushScanBatch(ImFileDialogScanJob* scan, ImFileDialogEntryList& files, ImFileDialogEntryList& directories, uint64_t& filesystemCalls)
+{
+	std::lock_guard<std::mutex> lock(scan->mutex);
+
+	scan->filesystemCalls += filesystemCalls;
+	filesystemCalls = 0;
+
+	scan->files.append(files);
+	scan->directories.append(directories);
+
+	files.clear();
+	directories.clear();
+}
+
+// Publishes the end of a scan job, and hands back the pool slot of a worker given up on.
+static void FinishScanJob(ImFileDialogScanJob* scan, std::error_code error, double durationMs)
+{
+	bool abandoned;
+	{
+		std::lock_guard<std::mutex> lock(scan->mutex);
+		scan->error = error;
+		scan->durationMs = durationMs;
+		scan->finished = true;
+		abandoned = scan->abandoned;
+	}
+	scan->done.notify_all();
+
+	std::shared_ptr<ImFileDialogService> service = scan->service.lock();
+	if (abandoned && service)
+	{
+		std::lock_guard<std::mutex> lock(service->pool.mutex);
+		service->pool.stalledThreads--;
+	}
+}
+
+// Gives up on a scan job whose worker may be stuck in a single call. The worker no longer counts
+// against poolMaxThreads until it returns.
+static void AbandonScanJob(ImFileDialogScanJob* scan)
+{
+	std::lock_guard<std::mutex> lock(scan->mutex);
+	std::shared_ptr<ImFileDialogService> service = scan->service.lock();
+	if (scan->finished || scan->abandoned || !service)
+		return;
+
+	scan->abandoned = true;
+	std::lock_guard<std::mutex> poolLock(service->pool.mutex);
+	service->pool.stalledThreads++;
+}
+
+static bool PoolStalled(const std::weak_ptr<ImFileDialogService>& weakService)
+{
+	std::shared_ptr<ImFileDialogService> service = weakService.lock();
+	if (!service)
+		return false;
+
+	std::lock_guard<std::mutex> lock(service->pool.mutex);
+	return service->pool.stalledThreads >= poolMaxStalledThreads;
+}
+
+// Lists the directory without throwing. Unreadable entries are kept and counted; a failed
+// listing, or one stopped by the deadline, maxEntries or cancellation, keeps what it listed and
+// reports the error, so it is never taken for the whole folder.
+static void ScanDirectory(std::shared_ptr<ImFileDialogScanJob> scan)
+{
+	// With poolMaxStalledThreads workers already hung, new listings fail rather than pile up.
+	if (PoolStalled(scan->service))
+	{
+		FinishScanJob(scan.get(), std::make_error_code(std::errc::resource_unavailable_try_again), 0.0);
+		return;
+	}
+
+	ImFileDialogEntryList files;
+	ImFileDialogEntryList directories;
+	auto start = std::chrono::steady_clock::now();
+	auto lastFlush = start;
+	scan->started = start;
+	uint64_t filesystemCalls = 2;
+	bool timedOut = false;
+	bool truncated = false;
+
+	std::error_code error;
+	if (!scan->listDirectory)
+		scan->lastWriteTime = std::filesystem::last_write_time(scan->directoryPath, error);
+	else
+		scan->lastWriteTime = ImFileDialogEntryList::unknownTime;
+
+	auto added = [&]()
+	{
+		if (++scan->scannedEntries > scan->maxEntries)
+		{
+			truncated = true;
+			scan->cancelled = true;
+		}
+
+		// A custom backend may block before its next entry, so it gets nothing held back.
+		auto now = std::chrono::steady_clock::now();
+		if (scan->listDirectory || files.size() + directories.size() >= scanBatchSize || now - lastFlush >= scanBatchInterval)
+		{
+			FlushScanBatch(scan.get(), files, directories, filesystemCalls);
+			lastFlush = now;
+		}
+
+		timedOut = now >= scan->deadline;
+		return !scan->cancelled && !timedOut;
+	};
+
+	if (scan->listDirectory)
+	{
+		scan->listDirectory(scan->directoryPath, [&](const ImFileDialogDirectoryEntry& entry)
+			{
+				if (entry.error)
+					scan->entryErrors++;
+
+				if (entry.isDirectory)
+					directories.push_back(entry.name, entry.size, entry.lastWriteTime, 0);
+				else if (scan->type != ImGuiFileDialogType_SelectFolder)
+					files.push_back(entry.name, entry.size, entry.lastWriteTime, MatchFilters(scan->filters, entry.name));
+				return added();
+			}, error);
+	}
+#ifdef IMGUI_FILEDIALOG_READDIR
+	else if (scan->lazyMetadata)
+	{
+		ReadDirectoryNames(scan->directoryPath, filesystemCalls, error, [&](std::string_view name, bool isDirectory)
+			{
+				if (isDirectory)
+					directories.push_back(name, 0);
+				else if (scan->type != ImGuiFileDialogType_SelectFolder)
+					files.push_back(name, MatchFilters(scan->filters, name));
+				return added();
+			});
+	}
+#endif
+	else
+	{
+		std::filesystem::directory_iterator iterator(scan->directoryPath, error);
+		std::filesystem::directory_iterator end;
+
+		for (; !error && iterator != end; iterator.increment(error))
+		{
+			const std::filesystem::directory_entry& entry = *iterator;
+			std::error_code entryError;
+			bool read = true;
+
+			if (entry.is_directory(entryError))
+			{
+				read = AddEntry(directories, entry, entry.path().filename().string(), true, 0, filesystemCalls);
+			}
+			else if (scan->type != ImGuiFileDialogType_SelectFolder)
+			{
+				std::string name = entry.path().filename().string();
+				read = AddEntry(files, entry, name, false, MatchFilters(scan->filters, name), filesystemCalls);
+			}
+
+			if (entryError || !read)
+				scan->entryErrors++;
+
+			if (!added())
+				break;
+		}
+	}
+
+	FlushScanBatch(scan.get(), files, directories, filesystemCalls);
+
+	if (!error && truncated)
+		error = std::make_error_code(std::errc::value_too_large);
+	else if (!error && timedOut)
+		error = std::make_error_code(std::errc::timed_out);
+	else if (!error && scan->cancelled)
+		error = std::make_error_code(std::errc::operation_canceled);
+	FinishScanJob(scan.get(), error, ElapsedMs(start));
+}
+
+// Scans through a custom listDirectory are never shared, as there is no telling two apart.
+static bool SameScan(const ImFileDialogScanJob& scan, const ImFileDialogInfo* dialogInfo, const std::filesystem::path& directoryPath, uint64_t filtersFingerprint)
+{
+	return scan.directoryPath == directoryPath && scan.type == dialogInfo->type && scan.filtersFingerprint == filtersFingerprint && scan.lazyMetadata == dialogInfo->lazyMetadata && !scan.listDirectory && !dialogInfo->listDirectory;
+}
+
+static std::shared_ptr<ImFileDialogScanJob> MakeScanJob(ImFileDialogInfo* dialogInfo, const std::filesystem::path& directoryPath)
+{
+	auto job = std::make_shared<ImFileDialogScanJob>();
+	job->service = ServiceOf(dialogInfo);
+	job->directoryPath = directoryPath;
+	job->type = dialogInfo->type;
+	job->filters = dialogInfo->parsedFilters;
+	job->filtersFingerprint = FiltersFingerprint(dialogInfo->parsedFilters);
+	job->lazyMetadata = dialogInfo->lazyMetadata;
+	job->listDirectory = dialogInfo->listDirectory;
+
+	if (dialogInfo->scanDeadlineMs > 0.0)
+		job->deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(dialogInfo->scanDeadlineMs));
+
+	return job;
+}
+
+// Joins a running scan of the same listing, or submits a new one.
+static std::shared_ptr<ImFileDialogScanJob> FindOrStartScan(ImFileDialogInfo* dialogInfo, const std::filesystem::path& directoryPath, bool& started)
+{
+	ImFileDialogService* service = ServiceOf(dialogInfo).get();
+	uint64_t filtersFingerprint = FiltersFingerprint(dialogInfo->parsedFilters);
+	std::lock_guard<std::mutex> lock(service->mutex);
+
+	std::shared_ptr<ImFileDialogScanJob> job;
+	for (size_t i = 0; i < service->scans.size();)
+	{
+		std::shared_ptr<ImFileDialogScanJob> scan = service->scans[i].lock();
+		if (!scan || scan->cancelled)
+		{
+			service->scans[i] = std::move(service->scans.back());
+			service->scans.pop_back();
+			continue;
+		}
+
+		// A finished job may outlive its task for a moment; its listing is no longer current.
+		if (!job && !scan->finished && SameScan(*scan, dialogInfo, directoryPath, filtersFingerprint))
+			job = scan;
+		++i;
+	}
+
+	started = !job;
+	if (job)
+		return job;
+
+	job = MakeScanJob(dialogInfo, directoryPath);
+	service->scans.push_back(job);
+	SubmitTask(ServiceOf(dialogInfo), [job]() { ScanDirectory(job); });
+	return job;
+}
+
+// Shows the listing of a scan job as it streams in: a new or joined one, or `job` when given.
+static void StartScan(ImFileDialogInfo* dialogInfo, std::shared_ptr<ImFileDialogScanJob> job = nullptr)
+{
+	CancelScan(dialogInfo);
+
+	dialogInfo->scannedPath = dialogInfo->directoryPath;
+	dialogInfo->refreshInfo = false;
+	dialogInfo->refreshSort = true;
+	dialogInfo->currentIndex = 0;
+	dialogInfo->currentFiles.clear();
+	dialogInfo->currentDirectories.clear();
+	dialogInfo->search.reset();
+	ClearSelection(dialogInfo);
+	CancelMetadata(dialogInfo);
+	CancelFolderSizes(dialogInfo);
+	CancelColumnValues(dialogInfo);
+
+	auto scan = std::make_shared<ImFileDialogScan>();
+	scan->owner = job != nullptr;
+	scan->job = job ? std::move(job) : FindOrStartScan(dialogInfo, dialogInfo->directoryPath, scan->owner);
+	scan->job->subscribers++;
+
+	dialogInfo->scan = scan;
+}
+
+// Copies the entries listed since the last call. Only the dialog that started the job counts its
+// filesystem calls, so a shared scan is not counted twice.
+static void ConsumeScan(ImFileDialogInfo* dialogInfo)
+{
+	ImFileDialogScan* scan = dialogInfo->scan.get();
+	if (!scan->job)
+		return;
+
+	ImFileDialogScanJob* job = scan->job.get();
+	ImFileDialogCounters& counters = dialogInfo->stats.frame;
+	ImFileDialogTimer timer{ counters.scanMs };
+	std::unique_lock<std::mutex> lock(job->mutex);
+
+	counters.scannedEntries += job->files.size() - scan->consumedFiles + job->directories.size() - scan->consumedDirectories;
+	if (scan->owner)
+		counters.filesystemCalls += job->filesystemCalls.exchange(0);
+
+	dialogInfo->currentFiles.append(job->files, scan->consumedFiles);
+	dialogInfo->currentDirectories.append(job->directories, scan->consumedDirectories);
+	scan->consumedFiles = job->files.size();
+	scan->consumedDirectories = job->directories.size();
+	scan->scannedEntries = job->scannedEntries;
+
+	scan->entryErrors = job->entryErrors;
+
+	if (job->finished)
+	{
+		// A cancelled job may have stopped short without a word; it is never taken as complete.
+		scan->finished = true;
+		scan->error = job->error;
+		if (!scan->error && job->cancelled)
+			scan->error = std::make_error_code(std::errc::operation_canceled);
+		dialogInfo->scannedWriteTime = job->lastWriteTime;
+		dialogInfo->stats.lastScanMs = job->durationMs;
+		scan->started = job->started;
+
+		lock.unlock();
+		job->subscribers--;
+		scan->job.reset();
+
+		if (!scan->error)
+			StoreListing(dialogInfo, true);
+	}
+	else if (std::chrono::steady_clock::now() >= job->deadline)
+	{
+		// The worker checks the deadline between entries; this catches one stuck on a single call.
+		lock.unlock();
+		scan->finished = true;
+		scan->error = std::make_error_code(std::errc::timed_out);
+		AbandonScanJob(job);
+		scan->release();
+	}
+}
+
+// Stops reading the scan on screen and keeps the entries listed so far. The job is cancelled
+// unless another dialog still reads it.
+static void StopScan(ImFileDialogInfo* dialogInfo, std::errc reason)
+{
+	ImFileDialogScan* scan = dialogInfo->scan.get();
+	if (!scan || scan->finished)
+		return;
+
+	ConsumeScan(dialogInfo);
+	if (scan->finished)
+		return;
+
+	scan->finished = true;
+	scan->error = std::make_error_code(reason);
+	AbandonScanJob(scan->job.get());
+	scan->release();
+}
+
+// Lists directoryPath without throwing. Waits up to syncScanTimeoutMs for the scan to finish;
+// a slower one keeps streaming in like an async scan.
+void RefreshInfo(ImFileDialogInfo* dialogInfo)
+{
+	StartScan(dialogInfo);
+
+	ImFileDialogScanJob* job = dialogInfo->scan->job.get();
+	auto timeout = std::chrono::duration<double, std::milli>(std::max(dialogInfo->syncScanTimeoutMs, 0.0));
+
+	{
+		ImFileDialogTimer timer{ dialogInfo->stats.frame.scanMs };
+		std::unique_lock<std::mutex> lock(job->mutex);
+		job->done.wait_for(lock, timeout, [job]() { return job->finished.load(); });
+	}
+
+	ConsumeScan(dialogInfo);
+}
+
+// Copies the listing of a finished scan job into the shared cache, unless it failed, was cut
+// short or would not fit.
+static void CacheScanJob(ImFileDialogService* service, ImFileDialogScanJob* job, size_t maxListings, size_t maxBytes)
+{
+	if (job->error || job->cancelled || job->listDirectory)
+		return;
+
+	ImFileDialogListing listing;
+	listing.directoryPath = job->directoryPath;
+	listing.lastWriteTime = job->lastWriteTime;
+	listing.type = job->type;
+	listing.filtersFingerprint = job->filtersFingerprint;
+	listing.lazyMetadata = job->lazyMetadata;
+
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		if (job->files.bytes() + job->directories.bytes() > maxBytes)
+			return;
+
+		listing.files = job->files;
+		listing.directories = job->directories;
+	}
+
+	InsertListing(service, std::move(listing), maxListings, maxBytes);
+}
+
+// Lists a folder on the worker pool straight into the shared cache, unless it is cached and
+// unmodified. Dialogs opening the folder while it is listed join the scan.
+static void PrefetchListing(ImFileDialogInfo* dialogInfo, const std::filesystem::path& directoryPath)
+{
+	// Listings of a custom listDirectory are not cached.
+	if (dialogInfo->listDirectory)
+		return;
+
+	auto job = MakeScanJob(dialogInfo, directoryPath);
+
+	std::shared_ptr<ImFileDialogService> service = ServiceOf(dialogInfo);
+	size_t maxListings = dialogInfo->cacheMaxListings;
+	size_t maxBytes = dialogInfo->cacheMaxBytes;
+
+	SubmitTask(service, [service, job, maxListings, maxBytes]()
+		{
+			std::error_code error;
+			std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(job->directoryPath, error);
+			if (error)
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock(service->mutex);
+
+				for (const ImFileDialogListing& listing : service->cache.listings)
+				{
+					if (SameListing(listing, job->directoryPath, job->type, job->filtersFingerprint, job->lazyMetadata) && listing.lastWriteTime == lastWriteTime)
+						return;
+				}
+
+				for (const std::weak_ptr<ImFileDialogScanJob>& weakScan : service->scans)
+				{
+					std::shared_ptr<ImFileDialogScanJob> scan = weakScan.lock();
+					if (scan && !scan->cancelled && scan->directoryPath == job->directoryPath && scan->type == job->type && scan->filtersFingerprint == job->filtersFingerprint && scan->lazyMetadata == job->lazyMetadata)
+						return;
+				}
+
+				service->scans.push_back(job);
+			}
+
+			ScanDirectory(job);
+			CacheScanJob(service.get(), job.get(), maxListings, maxBytes);
+		});
+}
+
+static void PrefetchRecent(ImFileDialogInfo* dialogInfo)
+{
+	size_t count = std::min(dialogInfo->prefetchRecent, dialogInfo->recentDirectories.size());
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (dialogInfo->recentDirectories[i] != dialogInfo->directoryPath)
+			PrefetchListing(dialogInfo, dialogInfo->recentDirectories[i]);
+	}
+}
+
+// Moves the path to the front of the list, keeping at most maxEntries.
+static void AddPlace(std::vector<std::filesystem::path>& places, const std::filesystem::path& path, size_t maxEntries)
+{
+	places.erase(std::remove(places.begin(), places.end(), path), places.end());
+	places.insert(places.begin(), path);
+
+	if (places.size() > maxEntries)
+		places.resize(maxEntries);
+}
+
+// Reads a places file, one "bookmark <path>" or "recent <path>" per line, after the places
+// already in the lists. A missing file is an empty one.
+static void ReadPlaces(const std::filesystem::path& placesFile, std::vector<std::filesystem::path>& bookmarks, std::vector<std::filesystem::path>& recentDirectories, size_t recentMaxEntries)
+{
+	std::ifstream file(placesFile);
+	std::string line;
+
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		std::vector<std::filesystem::path>* places = nullptr;
+		size_t prefix = 0;
+
+		if (line.rfind("bookmark ", 0) == 0)
+		{
+			places = &bookmarks;
+			prefix = 9;
+		}
+		else if (line.rfind("recent ", 0) == 0)
+		{
+			places = &recentDirectories;
+			prefix = 7;
+		}
+
+		std::filesystem::path path = line.substr(prefix);
+		if (places && !path.empty() && std::find(places->begin(), places->end(), path) == places->end())
+			places->push_back(path);
+	}
+
+	if (recentDirectories.size() > recentMaxEntries)
+		recentDirectories.resize(recentMaxEntries);
+}
+
+// Reads the places file on the worker pool; UpdatePlaces merges it once read.
+static void LoadPlaces(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->placesLoaded || dialogInfo->placesFile.empty())
+		return;
+
+	dialogInfo->placesLoaded = true;
+
+	auto load = std::make_shared<ImFileDialogPlacesLoad>();
+	load->placesFile = dialogInfo->placesFile;
+	load->recentMaxEntries = dialogInfo->recentMaxEntries;
+	dialogInfo->placesLoad = load;
+
+	SubmitTask(ServiceOf(dialogInfo), [load]()
+		{
+			ReadPlaces(load->placesFile, load->bookmarks, load->recentDirectories, load->recentMaxEntries);
+
+			std::lock_guard<std::mutex> lock(load->mutex);
+			load->finished = true;
+			load->done.notify_all();
+		});
+}
+
+// Appends the places read from the file after the ones set meanwhile, and lists the recent
+// folders it brought in the background. Returns whether the file was merged.
+static bool UpdatePlaces(ImFileDialogInfo* dialogInfo)
+{
+	ImFileDialogPlacesLoad* load = dialogInfo->placesLoad.get();
+	if (!load || !load->finished)
+		return false;
+
+	for (const std::filesystem::path& path : load->bookmarks)
+	{
+		if (std::find(dialogInfo->bookmarks.begin(), dialogInfo->bookmarks.end(), path) == dialogInfo->bookmarks.end())
+			dialogInfo->bookmarks.push_back(path);
+	}
+
+	for (const std::filesystem::path& path : load->recentDirectories)
+	{
+		if (std::find(dialogInfo->recentDirectories.begin(), dialogInfo->recentDirectories.end(), path) == dialogInfo->recentDirectories.end())
+			dialogInfo->recentDirectories.push_back(path);
+	}
+
+	if (dialogInfo->recentDirectories.size() > dialogInfo->recentMaxEntries)
+		dialogInfo->recentDirectories.resize(dialogInfo->recentMaxEntries);
+
+	dialogInfo->placesLoad.reset();
+	PrefetchRecent(dialogInfo);
+	return true;
+}
+
+// Writes the places on the worker pool: a temporary file renamed over the places file, so it is
+// never left half written. Saves run one at a time and a save older than the last one written
+// is dropped. While the file is still being loaded, the save reads it first, so places the
+// dialog has not merged yet are kept.
+static void SavePlaces(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->placesFile.empty())
+		return;
+
+	const std::shared_ptr<ImFileDialogService>& service = ServiceOf(dialogInfo);
+	uint64_t save = ++service->placesSaves;
+
+	SubmitTask(service, [service, save, placesFile = dialogInfo->placesFile, bookmarks = dialogInfo->bookmarks,
+		recentDirectories = dialogInfo->recentDirectories, recentMaxEntries = dialogInfo->recentMaxEntries,
+		merge = dialogInfo->placesLoad != nullptr]() mutable
+		{
+			std::lock_guard<std::mutex> lock(service->placesMutex);
+			if (save < service->placesWritten)
+				return;
+			service->placesWritten = save;
+
+			if (merge)
+				ReadPlaces(placesFile, bookmarks, recentDirectories, recentMaxEntries);
+
+			std::error_code error;
+			if (placesFile.has_parent_path())
+				std::filesystem::create_directories(placesFile.parent_path(), error);
+
+			std::filesystem::path temporaryFile = placesFile;
+			temporaryFile += ".tmp";
+
+			{
+				std::ofstream file(temporaryFile, std::ios::trunc);
+
+				for (const std::filesystem::path& path : bookmarks)
+					file << "bookmark " << path.string() << '\n';
+				for (const std::filesystem::path& path : recentDirectories)
+					file << "recent " << path.string() << '\n';
+
+				file.close();
+				if (!file)
+					return;
+			}
+
+			std::filesystem::rename(temporaryFile, placesFile, error);
+		});
+}
+
+static void CancelSpeculation(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->speculation && dialogInfo->speculation->pending)
+		dialogInfo->speculation->pending->cancelled = true;
+
+	dialogInfo->speculation.reset();
+}
+
+// Lists a folder on the worker pool, unless the service already runs speculativeMaxScans such
+// scans; the caller tries again on a later frame. Folders past speculativeMaxEntries are dropped.
+static std::shared_ptr<ImFileDialogScanJob> StartSpeculativeScan(ImFileDialogInfo* dialogInfo, const std::filesystem::path& directoryPath)
+{
+	std::shared_ptr<ImFileDialogService> service = ServiceOf(dialogInfo);
+	if (service->speculativeScans.fetch_add(1) >= speculativeMaxScans)
+	{
+		service->speculativeScans--;
+		return nullptr;
+	}
+
+	auto job = MakeScanJob(dialogInfo, directoryPath);
+	job->maxEntries = speculativeMaxEntries;
+
+	SubmitTask(service, [service, job]()
+		{
+			// The pointer may have moved on while the task was queued.
+			if (job->cancelled)
+				FinishScanJob(job.get(), std::make_error_code(std::errc::operation_canceled), 0.0);
+			else
+			{
+				ScanDirectory(job);
+			}
+
+			service->speculativeScans--;
+		});
+
+	return job;
+}
+
+// Lists the folder hovered for speculativeHoverDelay, or else the selected one, in the
+// background. A scan is cancelled as soon as its folder is neither.
+static void UpdateSpeculation(ImFileDialogInfo* dialogInfo, const std::filesystem::path& hoveredPath, const std::filesystem::path& selectedPath)
+{
+	if (!dialogInfo->speculativeScan || dialogInfo->listDirectory)
+	{
+		CancelSpeculation(dialogInfo);
+		return;
+	}
+
+	if (!dialogInfo->speculation)
+		dialogInfo->speculation = std::make_shared<ImFileDialogSpeculation>();
+
+	ImFileDialogSpeculation* speculation = dialogInfo->speculation.get();
+	double time = ImGui::GetTime();
+
+	if (hoveredPath != speculation->hoveredPath)
+	{
+		speculation->hoveredPath = hoveredPath;
+		speculation->hoverStart = time;
+	}
+
+	const std::filesystem::path& target = !hoveredPath.empty() && time - speculation->hoverStart >= speculativeHoverDelay ? hoveredPath : selectedPath;
+
+	// Finished scans are kept even when they failed or ran too long, so they are not retried.
+	if (speculation->pending && speculation->pending->finished)
+	{
+		if (speculation->pending->cancelled || speculation->pending->error)
+		{
+			std::lock_guard<std::mutex> lock(speculation->pending->mutex);
+			speculation->pending->files = ImFileDialogEntryList();
+			speculation->pending->directories = ImFileDialogEntryList();
+		}
+
+		speculation->ready.push_front(std::move(speculation->pending));
+		if (speculation->ready.size() > speculativeMaxListings)
+			speculation->ready.pop_back();
+	}
+	else if (speculation->pending && speculation->pending->directoryPath != target)
+	{
+		speculation->pending->cancelled = true;
+		speculation->pending.reset();
+	}
+
+	if (target.empty() || speculation->pending)
+		return;
+
+	uint64_t filtersFingerprint = FiltersFingerprint(dialogInfo->parsedFilters);
+	for (const std::shared_ptr<ImFileDialogScanJob>& job : speculation->ready)
+	{
+		if (SameScan(*job, dialogInfo, target, filtersFingerprint))
+			return;
+	}
+
+	speculation->pending = StartSpeculativeScan(dialogInfo, target);
+}
+
+// Opens directoryPath from a speculative scan: a finished one, checked like a cached listing,
+// or the one still running, whose entries then stream in like those of an async scan.
+static bool AdoptSpeculation(ImFileDialogInfo* dialogInfo)
+{
+	ImFileDialogSpeculation* speculation = dialogInfo->speculation.get();
+	if (!speculation)
+		return false;
+
+	uint64_t filtersFingerprint = FiltersFingerprint(dialogInfo->parsedFilters);
+	std::shared_ptr<ImFileDialogScanJob> job;
+
+	if (speculation->pending && SameScan(*speculation->pending, dialogInfo, dialogInfo->directoryPath, filtersFingerprint))
+		job = std::move(speculation->pending);
+
+	for (auto it = speculation->ready.begin(); !job && it != speculation->ready.end(); ++it)
+	{
+		if (SameScan(**it, dialogInfo, dialogInfo->directoryPath, filtersFingerprint))
+		{
+			job = std::move(*it);
+			speculation->ready.erase(it);
+			break;
+		}
+	}
+
+	if (!job || job->cancelled || (job->finished && job->error))
+		return false;
+
+	// The folder is now opened, so a running scan lists all of it. One that already stopped at
+	// speculativeMaxEntries was cancelled and is not adopted.
+	job->maxEntries = SIZE_MAX;
+	if (job->cancelled)
+		return false;
+
+	bool finished = job->finished;
+	StartScan(dialogInfo, std::move(job));
+	if (finished)
+		dialogInfo->listingCheck = StartPathCheck(dialogInfo, dialogInfo->directoryPath);
+	return true;
+}
+
+// Copies the sub-folder names of a folder from the listing cache or the listing on screen,
+// without touching the disk. Returns false when neither holds the folder.
+static bool FindFolderNames(ImFileDialogInfo* dialogInfo, const std::filesystem::path& directoryPath, std::vector<std::pair<std::string, std::string>>& names, std::filesystem::file_time_type* lastWriteTime = nullptr)
+{
+	const ImFileDialogEntryList* directories = nullptr;
+	std::filesystem::file_time_type listedTime = ImFileDialogEntryList::unknownTime;
+	if (directoryPath == dialogInfo->scannedPath && !dialogInfo->walk && (!dialogInfo->scan || dialogInfo->scan->finished))
+	{
+		directories = &dialogInfo->currentDirectories;
+		listedTime = dialogInfo->scannedWriteTime;
+	}
+
+	ImFileDialogService* service = ServiceOf(dialogInfo).get();
+	std::lock_guard<std::mutex> lock(service->mutex);
+
+	for (const ImFileDialogListing& listing : service->cache.listings)
+	{
+		if (!directories && listing.directoryPath == directoryPath)
+		{
+			directories = &listing.directories;
+			listedTime = listing.lastWriteTime;
+		}
+	}
+
+	if (!directories)
+		return false;
+
+	if (lastWriteTime)
+		*lastWriteTime = listedTime;
+
+	names.clear();
+	names.reserve(directories->size());
+	for (size_t i = 0; i < directories->size(); ++i)
+	{
+		std::string name(directories->name(i));
+		names.emplace_back(ToLower(name), std::move(name));
+	}
+
+	return true;
+}
+
+// Points the index at the folder the path text names, and builds it once a listing is at hand.
+static void UpdatePathIndex(ImFileDialogInfo* dialogInfo, ImFileDialogPathBar* pathBar, const std::filesystem::path& directoryPath)
+{
+	if (directoryPath != pathBar->indexPath)
+	{
+		pathBar->indexPath = directoryPath;
+		pathBar->indexReady = false;
+		pathBar->indexRequested = false;
+		pathBar->index.clear();
+	}
+
+	if (pathBar->indexReady || directoryPath.empty())
+		return;
+
+	if (FindFolderNames(dialogInfo, directoryPath, pathBar->index))
+	{
+		std::sort(pathBar->index.begin(), pathBar->index.end());
+		pathBar->indexReady = true;
+	}
+	else if (!pathBar->indexRequested)
+	{
+		PrefetchListing(dialogInfo, directoryPath);
+		pathBar->indexRequested = true;
+	}
+}
+
+// Splits the path text into the folder it names so far and the partial name typed after it.
+static void SplitPathText(const std::string& text, std::filesystem::path& directoryPath, std::string& prefix)
+{
+	size_t separator = text.find_last_of(pathSeparators);
+	if (separator == std::string::npos)
+	{
+		directoryPath.clear();
+		prefix = text;
+		return;
+	}
+
+	directoryPath = text.substr(0, separator + 1);
+	if (directoryPath.has_relative_path() && !directoryPath.has_filename())
+		directoryPath = directoryPath.parent_path();
+	prefix = text.substr(separator + 1);
+}
+
+// The index entries whose lowercase name starts with the lowercase prefix.
+static std::pair<size_t, size_t> FindPathSuggestions(const ImFileDialogPathBar* pathBar, const std::string& prefix)
+{
+	std::string lower = ToLower(prefix);
+	auto& index = pathBar->index;
+
+	auto first = std::lower_bound(index.begin(), index.end(), lower, [](const std::pair<std::string, std::string>& entry, const std::string& key) { return entry.first < key; });
+	auto last = first;
+	while (last != index.end() && last->first.compare(0, lower.size(), lower) == 0)
+		++last;
+
+	return { (size_t)(first - index.begin()), (size_t)(last - index.begin()) };
+}
+
+// Tab completion: a single match completes to the folder and a separator, several extend the
+// text by the part they all share. Returns false when the text stays as it is.
+static bool CompletePath(ImFileDialogInfo* dialogInfo, ImFileDialogPathBar* pathBar, std::string& text)
+{
+	std::filesystem::path directoryPath;
+	std::string prefix;
+	SplitPathText(text, directoryPath, prefix);
+
+	UpdatePathIndex(dialogInfo, pathBar, directoryPath);
+	if (!pathBar->indexReady)
+		return false;
+
+	std::pair<size_t, size_t> range = FindPathSuggestions(pathBar, prefix);
+	if (range.first == range.second)
+		return false;
+
+	// The range is sorted, so what its first and last names share is what all of them share.
+	const std::pair<std::string, std::string>& first = pathBar->index[range.first];
+	const std::pair<std::string, std::string>& last = pathBar->index[range.second - 1];
+
+	size_t shared = 0;
+	while (shared < first.first.size() && shared < last.first.size() && first.first[shared] == last.first[shared])
+		++shared;
+
+	std::string completion = first.second.substr(0, shared);
+	if (range.second - range.first == 1)
+		completion += (char)std::filesystem::path::preferred_separator;
+
+	if (completion.size() <= prefix.size())
+		return false;
+
+	text.replace(text.size() - prefix.size(), prefix.size(), completion);
+	return true;
+}
+
+static std::filesystem::path TreeRootOf(const std::filesystem::path& path)
+{
+	return path.has_root_path() ? path.root_path() : path;
+}
+
+// Sets a node's sub-folders. A folder listed again keeps the state of the sub-folders it still
+// has; the nodes they were in are left unreachable until the tree is compacted.
+static void AddTreeChildren(ImFileDialogTree* tree, uint32_t index, std::vector<std::pair<std::string, std::string>>& names, std::filesystem::file_time_type lastWriteTime)
+{
+	std::sort(names.begin(), names.end());
+
+	std::unordered_map<std::string, uint32_t> previous;
+	const ImFileDialogTreeNode& node = tree->nodes[index];
+	for (uint32_t i = 0; i < node.childCount; ++i)
+		previous.emplace(tree->nodes[node.firstChild + i].name, node.firstChild + i);
+	tree->orphanedNodes += node.childCount;
+
+	std::filesystem::path path = node.path;
+	uint32_t depth = node.depth + 1;
+	tree->nodes[index].firstChild = (uint32_t)tree->nodes.size();
+	tree->nodes[index].childCount = (uint32_t)names.size();
+	tree->nodes[index].listed = true;
+	tree->nodes[index].lastWriteTime = lastWriteTime;
+
+	for (std::pair<std::string, std::string>& name : names)
+	{
+		ImFileDialogTreeNode child;
+		auto it = previous.find(name.second);
+		if (it != previous.end())
+		{
+			child = std::move(tree->nodes[it->second]);
+			tree->nodes[it->second] = ImFileDialogTreeNode();
+			std::replace(tree->listing.begin(), tree->listing.end(), it->second, (uint32_t)tree->nodes.size());
+		}
+		else
+		{
+			child.path = path / name.second;
+			child.name = std::move(name.second);
+			child.depth = depth;
+		}
+		tree->nodes.push_back(std::move(child));
+	}
+
+	tree->rowsStale = true;
+}
+
+// Takes the sub-folders from the listing on screen or the cache, or else joins or starts a
+// scan of the folder, which the listing can join in turn when the folder is opened. A known
+// `lastWriteTime` rules out listings from before the folder was last written.
+static void ListTreeNode(ImFileDialogInfo* dialogInfo, ImFileDialogTree* tree, uint32_t index, std::filesystem::file_time_type lastWriteTime)
+{
+	ImFileDialogTreeNode* node = &tree->nodes[index];
+
+	std::vector<std::pair<std::string, std::string>> names;
+	std::filesystem::file_time_type listedTime;
+	if (FindFolderNames(dialogInfo, node->path, names, &listedTime) && (lastWriteTime == ImFileDialogEntryList::unknownTime || listedTime == lastWriteTime))
+	{
+		AddTreeChildren(tree, index, names, listedTime);
+		return;
+	}
+
+	bool started = false;
+	node->job = FindOrStartScan(dialogInfo, node->path, started);
+	node->job->subscribers++;
+	tree->listing.push_back(index);
+}
+
+static void ExpandTreeNode(ImFileDialogInfo* dialogInfo, ImFileDialogTree* tree, uint32_t index)
+{
+	ImFileDialogTreeNode* node = &tree->nodes[index];
+	node->expanded = true;
+	tree->rowsStale = true;
+
+	if (!node->listed && !node->job)
+		ListTreeNode(dialogInfo, tree, index, ImFileDialogEntryList::unknownTime);
+}
+
+// Lists a node again; its old sub-folders stay shown until the new listing arrives.
+static void ReloadTreeNode(ImFileDialogInfo* dialogInfo, ImFileDialogTree* tree, uint32_t index, std::filesystem::file_time_type lastWriteTime)
+{
+	if (tree->nodes[index].job)
+		return;
+
+	tree->nodes[index].listed = false;
+	ListTreeNode(dialogInfo, tree, index, lastWriteTime);
+}
+
+static uint32_t FindTreeChild(const ImFileDialogTree* tree, uint32_t index, const std::string& name)
+{
+	const ImFileDialogTreeNode& node = tree->nodes[index];
+	for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; ++child)
+	{
+		if (tree->nodes[child].name == name)
+			return child;
+	}
+
+	return UINT32_MAX;
+}
+
+// The node of a folder whose parents are all listed, or UINT32_MAX.
+static uint32_t FindTreeNode(const ImFileDialogTree* tree, const std::filesystem::path& path)
+{
+	if (path == tree->nodes[0].path)
+		return 0;
+
+	uint32_t index = 0;
+	for (const std::filesystem::path& part : path.lexically_relative(tree->nodes[0].path))
+	{
+		if (!part.empty() && index != UINT32_MAX)
+			index = FindTreeChild(tree, index, part.string());
+	}
+
+	return index;
+}
+
+// Expands the folders above the one on screen as their listings arrive, then scrolls it into
+// view. Gives up on a folder missing from its parent's listing, such as a hidden one.
+static void RevealTreePath(ImFileDialogInfo* dialogInfo, ImFileDialogTree* tree)
+{
+	const std::filesystem::path& directoryPath = dialogInfo->directoryPath;
+	uint32_t index = 0;
+
+	if (directoryPath != tree->nodes[0].path)
+	{
+		for (const std::filesystem::path& part : directoryPath.lexically_relative(tree->nodes[0].path))
+		{
+			if (part.empty())
+				continue;
+
+			if (!tree->nodes[index].expanded)
+				ExpandTreeNode(dialogInfo, tree, index);
+			if (!tree->nodes[index].listed)
+				return;
+
+			index = FindTreeChild(tree, index, part.string());
+			if (index == UINT32_MAX)
+				break;
+		}
+	}
+
+	tree->revealing = false;
+	tree->scrollTo = index;
+}
+
+// Reads the write times of the expanded folders on a worker, every treeCheckInterval.
+static void StartTreeCheck(ImFileDialogInfo* dialogInfo, ImFileDialogTree* tree)
+{
+	tree->nextCheck = std::chrono::steady_clock::now() + treeCheckInterval;
+
+	auto check = std::make_shared<ImFileDialogTreeCheck>();
+	for (uint32_t index : tree->rows)
+	{
+		const ImFileDialogTreeNode& node = tree->nodes[index];
+		if (node.expanded && node.listed)
+			check->nodes.emplace_back(index, node.path);
+	}
+
+	if (check->nodes.empty())
+		return;
+
+	tree->check = check;
+	dialogInfo->stats.frame.filesystemCalls += check->nodes.size();
+
+	SubmitTask(ServiceOf(dialogInfo), [check]()
+		{
+			check->lastWriteTimes.reserve(check->nodes.size());
+			for (const std::pair<uint32_t, std::filesystem::path>& node : check->nodes)
+			{
+				std::error_code error;
+				std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(node.second, error);
+				check->lastWriteTimes.push_back(error ? ImFileDialogEntryList::unknownTime : lastWriteTime);
+			}
+			check->finished = true;
+		});
+}
+
+// Lists the folders written since they were listed again. A folder whose time could not be
+// read keeps its listing.
+static void ConsumeTreeCheck(ImFileDialogInfo* dialogInfo, ImFileDialogTree* tree)
+{
+	const ImFileDialogTreeCheck& check = *tree->check;
+	for (size_t i = 0; i < check.nodes.size(); ++i)
+	{
+		uint32_t index = check.nodes[i].first;
+		std::filesystem::file_time_type lastWriteTime = check.lastWriteTimes[i];
+		if (index >= tree->nodes.size() || tree->nodes[index].path != check.nodes[i].second || !tree->nodes[index].listed || lastWriteTime == ImFileDialogEntryList::unknownTime)
+			continue;
+
+		ImFileDialogTreeNode& node = tree->nodes[index];
+		if (node.lastWriteTime == ImFileDialogEntryList::unknownTime)
+			node.lastWriteTime = lastWriteTime;
+		else if (node.lastWriteTime != lastWriteTime)
+			ReloadTreeNode(dialogInfo, tree, index, lastWriteTime);
+	}
+
+	tree->check.reset();
+}
+
+// Drops the nodes left unreachable by folders listed again, keeping each node's children next
+// to each other. Scans of dropped nodes are released.
+static void CompactTree(ImFileDialogTree* tree)
+{
+	std::vector<uint32_t> remap(tree->nodes.size(), UINT32_MAX);
+	std::vector<ImFileDialogTreeNode> nodes;
+	nodes.reserve(tree->nodes.size() - tree->orphanedNodes);
+
+	remap[0] = 0;
+	nodes.push_back(std::move(tree->nodes[0]));
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		uint32_t firstChild = nodes[i].firstChild;
+		nodes[i].firstChild = (uint32_t)nodes.size();
+		for (uint32_t child = firstChild; child < firstChild + nodes[i].childCount; ++child)
+		{
+			remap[child] = (uint32_t)nodes.size();
+			nodes.push_back(std::move(tree->nodes[child]));
+		}
+	}
+
+	size_t listing = 0;
+	for (uint32_t index : tree->listing)
+	{
+		if (remap[index] != UINT32_MAX)
+		{
+			tree->listing[listing++] = remap[index];
+		}
+		else if (--tree->nodes[index].job->subscribers == 0)
+		{
+			tree->nodes[index].job->cancelled = true;
+		}
+	}
+	tree->listing.resize(listing);
+
+	if (tree->scrollTo != UINT32_MAX)
+		tree->scrollTo = remap[tree->scrollTo];
+
+	tree->nodes = std::move(nodes);
+	tree->orphanedNodes = 0;
+	tree->rowsStale = true;
+}
+
+// Adds the sub-folders of nodes whose scan has finished, and caches those listings unless the
+// dialog is showing the folder and caches it itself. Reveals the folder on screen, and lists
+// folders that changed again.
+static void UpdateTree(ImFileDialogInfo* dialogInfo)
+{
+	if (!dialogInfo->showTree)
+	{
+		dialogInfo->tree.reset();
+		return;
+	}
+
+	// A folder on another drive starts a tree of its own.
+	if (dialogInfo->tree && dialogInfo->directoryPath.has_root_path() && dialogInfo->tree->nodes[0].path != TreeRootOf(dialogInfo->directoryPath))
+		dialogInfo->tree.reset();
+
+	if (!dialogInfo->tree)
+	{
+		dialogInfo->tree = std::make_shared<ImFileDialogTree>();
+
+		ImFileDialogTreeNode root;
+		root.path = TreeRootOf(dialogInfo->directoryPath);
+		root.name = root.path.string();
+		dialogInfo->tree->nodes.push_back(std::move(root));
+		ExpandTreeNode(dialogInfo, dialogInfo->tree.get(), 0);
+	}
+
+	ImFileDialogTree* tree = dialogInfo->tree.get();
+
+	for (size_t i = 0; i < tree->listing.size();)
+	{
+		uint32_t index = tree->listing[i];
+		std::shared_ptr<ImFileDialogScanJob> job = tree->nodes[index].job;
+
+		// A scan past its deadline that is stuck in a call ends with what it listed, as in ConsumeScan.
+		if (!job->finished && std::chrono::steady_clock::now() < job->deadline)
+		{
+			++i;
+			continue;
+		}
+
+		if (job->finished && job->directoryPath != dialogInfo->scannedPath)
+			CacheScanJob(ServiceOf(dialogInfo).get(), job.get(), dialogInfo->cacheMaxListings, dialogInfo->cacheMaxBytes);
+		else if (!job->finished)
+			AbandonScanJob(job.get());
+
+		std::vector<std::pair<std::string, std::string>> names;
+		{
+			std::lock_guard<std::mutex> lock(job->mutex);
+			names.reserve(job->directories.size());
+			for (size_t j = 0; j < job->directories.size(); ++j)
+				names.emplace_back(ToLower(std::string(job->directories.name(j))), std::string(job->directories.name(j)));
+		}
+
+		if (--job->subscribers == 0)
+			job->cancelled = true;
+		tree->nodes[index].job.reset();
+		AddTreeChildren(tree, index, names, job->finished ? job->lastWriteTime : ImFileDialogEntryList::unknownTime);
+
+		tree->listing[i] = tree->listing.back();
+		tree->listing.pop_back();
+	}
+
+	if (tree->revealedPath != dialogInfo->directoryPath)
+	{
+		tree->revealedPath = dialogInfo->directoryPath;
+		tree->revealing = true;
+	}
+
+	if (tree->revealing)
+		RevealTreePath(dialogInfo, tree);
+
+	// The dialog's own listing of a refreshed folder is used once it has finished.
+	if (!tree->refreshedPath.empty() && (!dialogInfo->scan || dialogInfo->scan->finished))
+	{
+		uint32_t index = tree->refreshedPath == dialogInfo->scannedPath ? FindTreeNode(tree, tree->refreshedPath) : UINT32_MAX;
+		if (index != UINT32_MAX && tree->nodes[index].listed)
+			ReloadTreeNode(dialogInfo, tree, index, dialogInfo->scannedWriteTime);
+		tree->refreshedPath.clear();
+	}
+
+	if (tree->check && tree->check->finished)
+		ConsumeTreeCheck(dialogInfo, tree);
+	else if (!tree->check && std::chrono::steady_clock::now() >= tree->nextCheck)
+		StartTreeCheck(dialogInfo, tree);
+
+	if (tree->orphanedNodes > tree->nodes.size() / 2)
+		CompactTree(tree);
+
+	if (!tree->rowsStale)
+		return;
+
+	// Depth first over the expanded nodes; children are pushed in reverse to come out in order.
+	tree->rows.clear();
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty())
+	{
+		uint32_t index = stack.back();
+		stack.pop_back();
+		tree->rows.push_back(index);
+
+		const ImFileDialogTreeNode& node = tree->nodes[index];
+		if (node.expanded)
+		{
+			for (uint32_t child = node.childCount; child-- > 0;)
+				stack.push_back(node.firstChild + child);
+		}
+	}
+
+	tree->rowsStale = false;
+}
+
+static bool PopWalkTask(ImFileDialogWalk* walk, size_t worker, ImFileDialogWalkTask& task)
+{
+	{
+		ImFileDialogWalkQueue& queue = *walk->queues[worker];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			walk->queuedTasks--;
+			return true;
+		}
+	}
+
+	// Steal the oldest task of another worker; it is the closest to the root and carries the most work.
+	for (size_t i = 1; i < walk->queues.size(); ++i)
+	{
+		ImFileDialogWalkQueue& victim = *walk->queues[(worker + i) % walk->queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			walk->queuedTasks--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Wakes waiting workers after a task was queued, or all of them once the walk has ended. The
+// idle mutex is taken so a worker between its check and its wait cannot miss the notification.
+static void WakeWalkers(ImFileDialogWalk* walk, bool all)
+{
+	{
+		std::lock_guard<std::mutex> lock(walk->idleMutex);
+	}
+
+	if (all)
+		walk->wake.notify_all();
+	else
+		walk->wake.notify_one();
+}
+
+#ifdef _WIN32
+static bool VisitOnce(ImFileDialogWalk* walk, const std::filesystem::path& canonicalPath)
+{
+	std::lock_guard<std::mutex> lock(walk->visitedMutex);
+	return walk->visited.insert(canonicalPath.native()).second;
+}
+#else
+static bool VisitOnce(ImFileDialogWalk* walk, const struct stat& status)
+{
+	std::lock_guard<std::mutex> lock(walk->visitedMutex);
+	return walk->visited.insert({ (uint64_t)status.st_dev, (uint64_t)status.st_ino }).second;
+}
+#endif
+
+static bool AddWalkResult(ImFileDialogWalk* walk)
+{
+	if (walk->results++ < walk->maxResults)
+		return true;
+
+	walk->truncated = true;
+	walk->cancelled = true;
+	WakeWalkers(walk, true);
+	return false;
+}
+
+static void WalkDirectories(std::shared_ptr<ImFileDialogWalk> walk, size_t worker)
+{
+	ImFileDialogWalkQueue& queue = *walk->queues[worker];
+	ImFileDialogEntryList files;
+	ImFileDialogEntryList directories;
+	ImFileDialogWalkTask task;
+	uint64_t filesystemCalls = 0;
+
+	// A task is counted until its directory has been read, and children are counted before that,
+	// so the count only drops to zero once the whole subtree is done.
+	while (!walk->cancelled && walk->pendingTasks > 0)
+	{
+		if (!PopWalkTask(walk.get(), worker, task))
+		{
+			std::unique_lock<std::mutex> lock(walk->idleMutex);
+			walk->wake.wait(lock, [&]() { return walk->cancelled || walk->pendingTasks == 0 || walk->queuedTasks > 0; });
+			continue;
+		}
+
+		std::error_code error;
+
+#ifdef _WIN32
+		// The root is resolved here rather than by the dialog, which must not wait on the disk.
+		if (task.canonicalPath.empty())
+		{
+			task.canonicalPath = std::filesystem::canonical(task.directoryPath, error);
+			if (error)
+				task.canonicalPath = task.directoryPath;
+			VisitOnce(walk.get(), task.canonicalPath);
+			filesystemCalls++;
+			error.clear();
+		}
+#else
+		// One stat per directory identifies it however it was reached. A directory that cannot
+		// be read is left to the listing below to report.
+		struct stat status;
+		filesystemCalls++;
+		if (stat(task.directoryPath.c_str(), &status) == 0 && !VisitOnce(walk.get(), status))
+		{
+			if (--walk->pendingTasks == 0)
+				WakeWalkers(walk.get(), true);
+			continue;
+		}
+#endif
+
+		std::filesystem::directory_iterator iterator(task.directoryPath, std::filesystem::directory_options::skip_permission_denied, error);
+		std::filesystem::directory_iterator end;
+		filesystemCalls++;
+
+		for (; !error && iterator != end && !walk->cancelled; iterator.increment(error))
+		{
+			const std::filesystem::directory_entry& entry = *iterator;
+			std::filesystem::path fileName = entry.path().filename();
+			std::error_code entryError;
+			bool isDirectory = entry.is_directory(entryError);
+
+			if (isDirectory && task.depth < walk->maxDepth)
+			{
+				ImFileDialogWalkTask child;
+				child.directoryPath = entry.path();
+				child.relativePath = task.relativePath / fileName;
+				child.depth = task.depth + 1;
+
+				bool enter = true;
+#ifdef _WIN32
+				// Only symlinks can lead back into the walked tree, so only they need resolving.
+				if (entry.is_symlink(entryError))
+				{
+					child.canonicalPath = std::filesystem::canonical(entry.path(), entryError);
+					filesystemCalls += 2;
+				}
+				else
+					child.canonicalPath = task.canonicalPath / fileName;
+
+				enter = !entryError && VisitOnce(walk.get(), child.canonicalPath);
+#endif
+
+				if (enter)
+				{
+					walk->pendingTasks++;
+					{
+						std::lock_guard<std::mutex> lock(queue.mutex);
+						queue.tasks.push_back(std::move(child));
+					}
+					walk->queuedTasks++;
+					WakeWalkers(walk.get(), false);
+				}
+			}
+
+			if (!isDirectory && walk->type == ImGuiFileDialogType_SelectFolder)
+				continue;
+
+			std::string name = fileName.string();
+			std::string lowerName = ToLower(name);
+			if (walk->fuzzy ? !MatchSubsequence(lowerName, walk->query) : lowerName.find(walk->query) == std::string::npos)
+				continue;
+
+			if (!AddWalkResult(walk.get()))
+				break;
+
+			uint64_t filterMask = isDirectory ? 0 : MatchFilters(walk->filters, name);
+			AddEntry(isDirectory ? directories : files, entry, (task.relativePath / fileName).string(), isDirectory, filterMask, filesystemCalls);
+		}
+
+		if (!files.empty() || !directories.empty())
+		{
+			std::lock_guard<std::mutex> lock(walk->mutex);
+			walk->pendingFiles.append(files);
+			walk->pendingDirectories.append(directories);
+			files.clear();
+			directories.clear();
+		}
+
+		walk->filesystemCalls += filesystemCalls;
+		filesystemCalls = 0;
+		walk->scannedDirectories++;
+		if (--walk->pendingTasks == 0)
+			WakeWalkers(walk.get(), true);
+	}
+
+	if (--walk->runningWorkers == 0)
+		walk->finished = true;
+}
+
+static void StartWalk(ImFileDialogInfo* dialogInfo)
+{
+	auto walk = std::make_shared<ImFileDialogWalk>();
+	walk->directoryPath = dialogInfo->directoryPath;
+	walk->type = dialogInfo->type;
+	walk->filters = dialogInfo->parsedFilters;
+	walk->query = ToLower(dialogInfo->searchQuery);
+	walk->fuzzy = dialogInfo->fuzzySearch;
+	walk->maxDepth = dialogInfo->recursiveSearchDepth;
+	walk->maxResults = dialogInfo->recursiveSearchLimit;
+
+	unsigned workerCount = std::clamp(std::thread::hardware_concurrency(), 1u, walkMaxWorkers);
+	for (unsigned i = 0; i < workerCount; ++i)
+		walk->queues.push_back(std::make_unique<ImFileDialogWalkQueue>());
+
+	ImFileDialogWalkTask root;
+	root.directoryPath = dialogInfo->directoryPath;
+
+	walk->queues[0]->tasks.push_back(std::move(root));
+	walk->queuedTasks = 1;
+	walk->pendingTasks = 1;
+	walk->runningWorkers = workerCount;
+
+	dialogInfo->walk = walk;
+	for (unsigned i = 0; i < workerCount; ++i)
+		SubmitTask(ServiceOf(dialogInfo), [walk, i]() { WalkDirectories(walk, i); });
+}
+
+static void CancelWalk(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->walk)
+	{
+		dialogInfo->walk->cancelled = true;
+		WakeWalkers(dialogInfo->walk.get(), true);
+		dialogInfo->walk.reset();
+	}
+}
+
+// Starts, restarts or stops the subtree search to match the query and the options, then
+// moves the results found so far into the listing shown in place of the directory.
+static void UpdateWalk(ImFileDialogInfo* dialogInfo)
+{
+	bool active = dialogInfo->recursiveSearch && !dialogInfo->searchQuery.empty();
+	ImFileDialogWalk* walk = dialogInfo->walk.get();
+
+	if (walk && (!active || walk->directoryPath != dialogInfo->directoryPath || walk->query != ToLower(dialogInfo->searchQuery) || walk->fuzzy != dialogInfo->fuzzySearch || walk->maxDepth != dialogInfo->recursiveSearchDepth || walk->maxResults != dialogInfo->recursiveSearchLimit))
+	{
+		CancelWalk(dialogInfo);
+		ClearSelection(dialogInfo);
+		dialogInfo->refreshSort = true;
+		dialogInfo->currentIndex = 0;
+	}
+
+	// The selection holds indices into whichever listing is shown, so it starts over on a switch.
+	if (active && !dialogInfo->walk)
+	{
+		StartWalk(dialogInfo);
+		ClearSelection(dialogInfo);
+		dialogInfo->refreshSort = true;
+		dialogInfo->currentIndex = 0;
+	}
+
+	if (!dialogInfo->walk)
+		return;
+
+	walk = dialogInfo->walk.get();
+	ImFileDialogTimer timer{ dialogInfo->stats.frame.scanMs };
+	dialogInfo->stats.frame.filesystemCalls += walk->filesystemCalls.exchange(0);
+	std::lock_guard<std::mutex> lock(walk->mutex);
+
+	walk->files.append(walk->pendingFiles);
+	walk->directories.append(walk->pendingDirectories);
+
+	walk->pendingFiles.clear();
+	walk->pendingDirectories.clear();
+}
+
+static void Navigate(ImFileDialogInfo* dialogInfo, const std::filesystem::path& directoryPath)
+{
+	dialogInfo->backHistory.push_back(dialogInfo->directoryPath);
+	dialogInfo->forwardHistory.clear();
+	dialogInfo->directoryPath = directoryPath;
+	dialogInfo->refreshInfo = true;
+}
+
+// Acts on the folder status reads that came back from the workers since the last frame.
+static void UpdatePathChecks(ImFileDialogInfo* dialogInfo)
+{
+	ImFileDialogPathCheck* listingCheck = dialogInfo->listingCheck.get();
+	if (listingCheck && listingCheck->finished)
+	{
+		// The listing on screen came from before the folder was last modified; read it again.
+		if (listingCheck->path == dialogInfo->scannedPath && (listingCheck->error || listingCheck->lastWriteTime != dialogInfo->scannedWriteTime))
+			dialogInfo->refreshInfo = true;
+		dialogInfo->listingCheck.reset();
+	}
+
+	ImFileDialogPathCheck* navigationCheck = dialogInfo->navigationCheck.get();
+	if (!navigationCheck || !navigationCheck->finished)
+		return;
+
+	if (navigationCheck->isDirectory)
+	{
+		if (dialogInfo->walk)
+			dialogInfo->searchQuery.clear();
+
+		Navigate(dialogInfo, navigationCheck->path);
+	}
+
+	if (navigationCheck->places && !navigationCheck->isDirectory)
+	{
+		std::vector<std::filesystem::path>& places = *navigationCheck->places;
+		places.erase(std::remove(places.begin(), places.end(), navigationCheck->path), places.end());
+		SavePlaces(dialogInfo);
+	}
+	else if (!navigationCheck->places && dialogInfo->pathBar)
+	{
+		dialogInfo->pathBar->editing = !navigationCheck->isDirectory;
+		dialogInfo->pathBar->notFound = !navigationCheck->isDirectory;
+	}
+
+	dialogInfo->navigationCheck.reset();
+}
+
+// Adding the watch resolves the path, which can hang on a stalled mount, so a worker adds it.
+// A watch that could not be added is never ready and reports nothing.
+static void StartWatch(ImFileDialogInfo* dialogInfo)
+{
+	dialogInfo->watch.reset();
+
+#ifdef __linux__
+	auto watch = std::make_shared<ImFileDialogWatch>();
+	watch->directoryPath = dialogInfo->directoryPath;
+	dialogInfo->watch = watch;
+
+	SubmitTask(ServiceOf(dialogInfo), [watch]()
+		{
+			watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (watch->fd < 0)
+				return;
+
+			uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+			if (inotify_add_watch(watch->fd, watch->directoryPath.c_str(), mask) >= 0)
+			{
+				watch->readyTime = std::chrono::steady_clock::now();
+				watch->ready = true;
+			}
+		});
+#endif
+}
+
+// Drops entries by name while keeping the cached display order valid, so no re-sort is needed.
+// Returns the new index of every entry, UINT32_MAX for dropped ones, or nothing when none was.
+static std::vector<uint32_t> RemoveEntries(ImFileDialogEntryList& entries, std::vector<uint32_t>& order, const std::unordered_set<std::string>& names, ImFileDialogSelection* selection = nullptr)
+{
+	std::vector<uint32_t> remap(entries.size());
+	size_t kept = 0;
+
+	for (size_t i = 0; i < entries.size(); ++i)
+		remap[i] = names.count(std::string(entries.name(i))) ? UINT32_MAX : (uint32_t)kept++;
+
+	if (kept == entries.size())
+		return {};
+
+	entries.compact(remap);
+	if (selection)
+		selection->remap(remap);
+
+	size_t orderSize = 0;
+	for (uint32_t index : order)
+	{
+		if (remap[index] != UINT32_MAX)
+			order[orderSize++] = remap[index];
+	}
+	order.resize(orderSize);
+	return remap;
+}
+
+static uint32_t RemapIndex(const std::vector<uint32_t>& remap, uint32_t index)
+{
+	if (remap.empty())
+		return index;
+
+	return index < remap.size() ? remap[index] : UINT32_MAX;
+}
+
+// The number of entries below `count` that were kept.
+static size_t RemapCount(const std::vector<uint32_t>& remap, size_t count)
+{
+	if (remap.empty())
+		return count;
+
+	return (size_t)std::count_if(remap.begin(), remap.begin() + std::min(count, remap.size()), [](uint32_t index) { return index != UINT32_MAX; });
+}
+
+// Points queued requests at their entries' new indices and drops those of removed entries.
+template <typename Request, typename Remap>
+static void RemapRequests(std::deque<Request>& requests, Remap remap)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		requests[i].index = remap(requests[i]);
+		if (requests[i].index == UINT32_MAX)
+			continue;
+		if (kept != i)
+			requests[kept] = std::move(requests[i]);
+		kept++;
+	}
+	requests.resize(kept);
+}
+
+static void RemapCells(std::unordered_map<uint32_t, std::string>& cells, const std::vector<uint32_t>& remap)
+{
+	if (remap.empty())
+		return;
+
+	std::unordered_map<uint32_t, std::string> kept;
+	for (auto& cell : cells)
+	{
+		uint32_t index = RemapIndex(remap, cell.first);
+		if (index != UINT32_MAX)
+			kept.emplace(index, std::move(cell.second));
+	}
+	cells.swap(kept);
+}
+
+// Keeps the metadata, folder sizes and column values of entries a change left in place. Work
+// already running for a removed entry still finishes, and its result is ignored.
+static void RemapBackgroundWork(ImFileDialogInfo* dialogInfo, const std::vector<uint32_t>& files, const std::vector<uint32_t>& directories)
+{
+	if (files.empty() && directories.empty())
+		return;
+
+	auto remapEntry = [&](bool isDirectory, uint32_t index) { return RemapIndex(isDirectory ? directories : files, index); };
+
+	if (ImFileDialogMetadata* metadata = dialogInfo->metadata.get())
+	{
+		std::lock_guard<std::mutex> lock(metadata->mutex);
+		auto remap = [&](const ImFileDialogMetadataRequest& request) { return remapEntry(request.isDirectory, request.index); };
+		RemapRequests(metadata->visible, remap);
+		RemapRequests(metadata->bulk, remap);
+		for (ImFileDialogMetadataRequest& request : metadata->running)
+			request.index = remap(request);
+		for (ImFileDialogMetadataResult& result : metadata->results)
+			result.index = remapEntry(result.isDirectory, result.index);
+
+		metadata->bulkFiles = RemapCount(files, metadata->bulkFiles);
+		metadata->bulkDirectories = RemapCount(directories, metadata->bulkDirectories);
+	}
+
+	if (ImFileDialogFolderSizes* folderSizes = dialogInfo->folderSizes.get())
+	{
+		std::lock_guard<std::mutex> lock(folderSizes->mutex);
+		size_t requests = folderSizes->requests.size();
+		RemapRequests(folderSizes->requests, [&](const ImFileDialogFolderSizeRequest& request) { return RemapIndex(directories, request.index); });
+		folderSizes->pending -= requests - folderSizes->requests.size();
+		for (ImFileDialogFolderSizeRequest& request : folderSizes->running)
+			request.index = RemapIndex(directories, request.index);
+		for (ImFileDialogFolderSizeResult& result : folderSizes->results)
+			result.index = RemapIndex(directories, result.index);
+
+		folderSizes->queued = RemapCount(directories, folderSizes->queued);
+	}
+
+	if (ImFileDialogColumnValues* values = dialogInfo->columnValues.get())
+	{
+		std::lock_guard<std::mutex> lock(values->mutex);
+		auto remap = [&](const ImFileDialogColumnRequest& request)
+		{
+			uint32_t index = remapEntry(request.isDirectory, request.index);
+			if (index == UINT32_MAX && request.bulk)
+				values->cells[request.column].pending--;
+			return index;
+		};
+		RemapRequests(values->visible, remap);
+		RemapRequests(values->bulk, remap);
+		for (ImFileDialogColumnRequest& request : values->running)
+			request.index = remapEntry(request.isDirectory, request.index);
+		for (ImFileDialogColumnResult& result : values->results)
+			result.index = remapEntry(result.isDirectory, result.index);
+
+		for (ImFileDialogColumnCells& cells : values->cells)
+		{
+			RemapCells(cells.files, files);
+			RemapCells(cells.directories, directories);
+			cells.bulkFiles = RemapCount(files, cells.bulkFiles);
+			cells.bulkDirectories = RemapCount(directories, cells.bulkDirectories);
+		}
+	}
+}
+
+// Re-reads the changed names on a worker. Names that no longer exist come back without an entry.
+static void ReadChanges(ImFileDialogInfo* dialogInfo, std::unordered_set<std::string> names)
+{
+	auto changes = std::make_shared<ImFileDialogWatchChanges>();
+	changes->names = std::move(names);
+	dialogInfo->watch->changes = changes;
+
+	std::filesystem::path directoryPath = dialogInfo->scannedPath;
+	ImGuiFileDialogType type = dialogInfo->type;
+	ordered_map<std::string, ImFileDialogFilter> filters = dialogInfo->parsedFilters;
+
+	SubmitTask(ServiceOf(dialogInfo), [changes, directoryPath, type, filters]()
+		{
+			for (const std::string& name : changes->names)
+			{
+				std::error_code error;
+				std::filesystem::directory_entry entry(directoryPath / name, error);
+				changes->filesystemCalls++;
+
+				if (error || !entry.exists(error))
+					continue;
+
+				if (entry.is_directory(error))
+					AddEntry(changes->directories, entry, name, true, 0, changes->filesystemCalls);
+				else if (type != ImGuiFileDialogType_SelectFolder)
+					AddEntry(changes->files, entry, name, false, MatchFilters(filters, name), changes->filesystemCalls);
+			}
+
+			changes->finished = true;
+		});
+}
+
+// Applies re-read names as deltas: vanished entries are removed, new or modified ones are
+// re-added and merged into the display order like streamed scan results. Only the changed
+// entries lose their metadata, folder sizes and column values; a modified file stays selected.
+static void ApplyChanges(ImFileDialogInfo* dialogInfo, const ImFileDialogWatchChanges& changes)
+{
+	ImFileDialogCounters& counters = dialogInfo->stats.frame;
+	ImFileDialogTimer timer{ counters.scanMs };
+
+	std::unordered_set<std::string> selectedNames;
+	if (!dialogInfo->selection.empty())
+	{
+		for (uint32_t i = 0; i < dialogInfo->currentFiles.size(); ++i)
+		{
+			std::string name(dialogInfo->currentFiles.name(i));
+			if (dialogInfo->selection.contains(i) && changes.names.count(name))
+				selectedNames.insert(std::move(name));
+		}
+	}
+
+	std::vector<uint32_t> files = RemoveEntries(dialogInfo->currentFiles, dialogInfo->sortedFiles, changes.names, &dialogInfo->selection);
+	std::vector<uint32_t> directories = RemoveEntries(dialogInfo->currentDirectories, dialogInfo->sortedDirectories, changes.names);
+	RemapBackgroundWork(dialogInfo, files, directories);
+	dialogInfo->refreshDisplay = true;
+	dialogInfo->search.reset();
+
+	counters.filesystemCalls += changes.filesystemCalls;
+	counters.scannedEntries += changes.files.size() + changes.directories.size();
+	size_t firstAdded = dialogInfo->currentFiles.size();
+	dialogInfo->currentFiles.append(changes.files);
+	dialogInfo->currentDirectories.append(changes.directories);
+
+	for (size_t i = firstAdded; !selectedNames.empty() && i < dialogInfo->currentFiles.size(); ++i)
+	{
+		if (selectedNames.count(std::string(dialogInfo->currentFiles.name(i))))
+			dialogInfo->selection.set(i, true);
+	}
+}
+
+static void PollWatch(ImFileDialogInfo* dialogInfo)
+{
+#ifdef __linux__
+	// Events stay queued in the kernel until the scan has finished, so deltas never race streamed entries.
+	// The sort order belongs to the subtree search results while one is shown.
+	// Changes are read from the folder listed on screen, and wait until it is the watched one.
+	ImFileDialogWatch* watch = dialogInfo->watch.get();
+	if (!watch->ready || (dialogInfo->scan && !dialogInfo->scan->finished) || dialogInfo->walk || watch->directoryPath != dialogInfo->scannedPath)
+		return;
+
+	// A listing read before the watch was added, including one served from the cache, may have
+	// missed changes made in between; the folder is read once more with the watch in place.
+	if (!watch->caughtUp)
+	{
+		watch->caughtUp = true;
+		if (!dialogInfo->scan || dialogInfo->scan->started < watch->readyTime)
+		{
+			dialogInfo->refreshInfo = true;
+			return;
+		}
+	}
+
+	// One batch is re-read at a time, and the next events are read once it has been applied.
+	if (watch->changes)
+	{
+		if (watch->changes->finished)
+		{
+			ApplyChanges(dialogInfo, *watch->changes);
+			watch->changes.reset();
+		}
+		return;
+	}
+
+	alignas(inotify_event) char buffer[16 * 1024];
+	std::unordered_set<std::string> names;
+
+	for (;;)
+	{
+		ssize_t length = read(watch->fd, buffer, sizeof(buffer));
+		dialogInfo->stats.frame.filesystemCalls++;
+		if (length <= 0)
+			break;
+
+		for (char* cursor = buffer; cursor < buffer + length;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+			cursor += sizeof(inotify_event) + event->len;
+
+			// A folder gone or moved loses its watch, which is added again with the new listing.
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+			{
+				dialogInfo->watch.reset();
+				dialogInfo->refreshInfo = true;
+				return;
+			}
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				dialogInfo->refreshInfo = true;
+				return;
+			}
+
+			if (event->len > 0)
+				names.insert(event->name);
+		}
+	}
+
+	if (!names.empty())
+		ReadChanges(dialogInfo, std::move(names));
+#endif
+}
+
+static bool MapFile(ImFileDialogMappedFile& file, const std::filesystem::path& path, std::error_code& error)
+{
+#ifdef _WIN32
+	HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		error = std::error_code((int)GetLastError(), std::system_category());
+		return false;
+	}
+
+	// Pipes and devices would block a pool thread on read; only plain files are mapped.
+	if (GetFileType(handle) != FILE_TYPE_DISK)
+	{
+		error = std::make_error_code(std::errc::not_supported);
+		CloseHandle(handle);
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	bool mapped = false;
+	if (GetFileSizeEx(handle, &size))
+	{
+		file.size = (size_t)size.QuadPart;
+		mapped = file.size == 0;
+
+		if (!mapped && (file.mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr)) != nullptr)
+			mapped = (file.data = (const uint8_t*)MapViewOfFile(file.mapping, FILE_MAP_READ, 0, 0, 0)) != nullptr;
+	}
+
+	if (!mapped)
+		error = std::error_code((int)GetLastError(), std::system_category());
+
+	CloseHandle(handle);
+	return mapped;
+#else
+	// O_NONBLOCK keeps opening a FIFO from waiting for a writer; it is rejected right after.
+	int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0)
+	{
+		error = std::error_code(errno, std::generic_category());
+		return false;
+	}
+
+	struct stat status;
+	bool mapped = fstat(fd, &status) == 0;
+	if (mapped && !S_ISREG(status.st_mode))
+	{
+		close(fd);
+		error = std::make_error_code(std::errc::not_supported);
+		return false;
+	}
+
+	if (mapped)
+	{
+		file.size = (size_t)status.st_size;
+		if (file.size != 0)
+		{
+			void* data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+			mapped = data != MAP_FAILED;
+			file.data = mapped ? (const uint8_t*)data : nullptr;
+		}
+	}
+
+	if (!mapped)
+	{
+		error = std::error_code(errno, std::generic_category());
+		file.size = 0;
+	}
+
+	close(fd);
+	return mapped;
+#endif
+}
+
+static uint16_t ReadBE16(const uint8_t* data)
+{
+	return (uint16_t)(data[0] << 8 | data[1]);
+}
+
+static uint32_t ReadBE32(const uint8_t* data)
+{
+	return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+}
+
+static uint16_t ReadLE16(const uint8_t* data)
+{
+	return (uint16_t)(data[0] | data[1] << 8);
+}
+
+static uint32_t ReadLE32(const uint8_t* data)
+{
+	return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static uint64_t ReadLE64(const uint8_t* data)
+{
+	return (uint64_t)ReadLE32(data) | (uint64_t)ReadLE32(data + 4) << 32;
+}
+
+static std::string FormatDimensions(uint32_t width, uint32_t height)
+{
+	return std::to_string(width) + " x " + std::to_string(height) + " pixels";
+}
+
+// Reads image dimensions from the header of PNG, GIF, BMP and JPEG files.
+static bool DescribeImage(ImFileDialogPreviewData& preview, const uint8_t* data, size_t size)
+{
+	if (size >= 24 && std::memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0 && std::memcmp(data + 12, "IHDR", 4) == 0)
+	{
+		preview.format = "PNG image";
+		preview.details.push_back(FormatDimensions(ReadBE32(data + 16), ReadBE32(data + 20)));
+		return true;
+	}
+
+	if (size >= 10 && (std::memcmp(data, "GIF87a", 6) == 0 || std::memcmp(data, "GIF89a", 6) == 0))
+	{
+		preview.format = "GIF image";
+		preview.details.push_back(FormatDimensions(ReadLE16(data + 6), ReadLE16(data + 8)));
+		return true;
+	}
+
+	if (size >= 26 && data[0] == 'B' && data[1] == 'M')
+	{
+		int32_t height = (int32_t)ReadLE32(data + 22);
+		preview.format = "BMP image";
+		preview.details.push_back(FormatDimensions(ReadLE32(data + 18), (uint32_t)(height < 0 ? -height : height)));
+		return true;
+	}
+
+	if (size >= 4 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+	{
+		preview.format = "JPEG image";
+
+		// Walk the marker segments up to the frame header; only their headers are touched.
+		size_t offset = 2;
+		while (offset + 9 < size && data[offset] == 0xFF)
+		{
+			uint8_t marker = data[offset + 1];
+			if (marker == 0xFF)
+			{
+				offset++;
+				continue;
+			}
+
+			if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+			{
+				offset += 2;
+				continue;
+			}
+
+			if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+			{
+				preview.details.push_back(FormatDimensions(ReadBE16(data + offset + 7), ReadBE16(data + offset + 5)));
+				break;
+			}
+
+			if (marker == 0xD9 || marker == 0xDA)
+				break;
+
+			offset += 2 + ReadBE16(data + offset + 2);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+static uint64_t ParseTarNumber(const uint8_t* field, size_t length)
+{
+	// Sizes past 8 GiB are stored in base-256 with the high bit of the first byte set.
+	uint64_t value = 0;
+	if (field[0] & 0x80)
+	{
+		for (size_t i = 1; i < length; ++i)
+		{
+			if (value >> 56)
+				return UINT64_MAX;
+			value = value << 8 | field[i];
+		}
+		return value;
+	}
+
+	for (size_t i = 0; i < length && field[i] >= '0' && field[i] <= '7'; ++i)
+		value = value << 3 | (uint64_t)(field[i] - '0');
+	return value;
+}
+
+// Counts entries of ZIP, tar and gzip files from their directory records. Tar has no central
+// directory, so its headers are walked, skipping over every member's data.
+static bool DescribeArchive(ImFileDialogPreviewData& preview, const uint8_t* data, size_t size, const std::atomic<bool>& cancelled)
+{
+	if (size >= 4 && data[0] == 'P' && data[1] == 'K' && ((data[2] == 3 && data[3] == 4) || (data[2] == 5 && data[3] == 6)))
+	{
+		preview.format = "ZIP archive";
+
+		// The end of central directory record sits in the last 64 KiB, behind an optional comment.
+		size_t searchEnd = size >= 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+		for (size_t offset = size >= 22 ? size - 22 + 1 : 0; offset-- > searchEnd;)
+		{
+			if (ReadLE32(data + offset) != 0x06054b50)
+				continue;
+
+			uint64_t entries = ReadLE16(data + offset + 10);
+			if (entries == 0xFFFF && offset >= 20 && ReadLE32(data + offset - 20) == 0x07064b50)
+			{
+				uint64_t zip64Offset = ReadLE64(data + offset - 20 + 8);
+				if (size >= 56 && zip64Offset <= size - 56 && ReadLE32(data + zip64Offset) == 0x06064b50)
+					entries = ReadLE64(data + zip64Offset + 32);
+			}
+
+			preview.details.push_back(std::to_string(entries) + " entries");
+			break;
+		}
+		return true;
+	}
+
+	if (size >= 18 && data[0] == 0x1F && data[1] == 0x8B)
+	{
+		// The trailer holds the uncompressed size modulo 4 GiB; entries would need decompressing.
+		preview.format = "gzip archive";
+		preview.details.push_back(std::to_string(ReadLE32(data + size - 4)) + " bytes uncompressed (modulo 4 GiB)");
+		return true;
+	}
+
+	if (size >= 512 && std::memcmp(data + 257, "ustar", 5) == 0)
+	{
+		preview.format = "tar archive";
+
+		size_t entries = 0;
+		uint64_t offset = 0;
+		// Every bound is checked by subtraction so a corrupt size field cannot wrap the offset.
+		while (size - offset >= 512 && data[offset] != 0 && entries < previewTarMaxEntries && !cancelled)
+		{
+			const uint8_t* header = data + offset;
+			if (std::memcmp(header + 257, "ustar", 5) != 0)
+				break;
+
+			// Extended headers and long names describe the entry that follows them.
+			char type = (char)header[156];
+			if (type != 'x' && type != 'g' && type != 'L' && type != 'K')
+				entries++;
+
+			uint64_t member = ParseTarNumber(header + 124, 12);
+			if (member > size - offset - 512)
+				break;
+
+			offset += 512 + member;
+			uint64_t padding = (512 - member % 512) % 512;
+			if (padding > size - offset)
+				break;
+			offset += padding;
+		}
+
+		preview.details.push_back((entries == previewTarMaxEntries ? "more than " : "") + std::to_string(entries) + " entries");
+		return true;
+	}
+
+	return false;
+}
+
+// Lists the top-level keys of a JSON object, or counts the elements of a top-level array,
+// from the first previewJsonBytes of the file.
+static bool DescribeJson(ImFileDialogPreviewData& preview, const uint8_t* data, size_t size)
+{
+	size_t length = std::min(size, previewJsonBytes);
+	size_t start = 0;
+	while (start < length && std::isspace((unsigned char)data[start]))
+		start++;
+
+	if (start == length || (data[start] != '{' && data[start] != '['))
+		return false;
+
+	bool object = data[start] == '{';
+	bool expectingKey = object;
+	bool inString = false;
+	bool isKey = false;
+	bool empty = true;
+	int depth = 0;
+	size_t keyStart = 0;
+	size_t members = 0;
+	std::string keys;
+
+	size_t i = start;
+	for (; i < length; ++i)
+	{
+		char c = (char)data[i];
+		if (inString)
+		{
+			if (c == '\\')
+				i++;
+			else if (c == '"')
+			{
+				inString = false;
+				if (isKey && members <= previewJsonKeys)
+				{
+					keys += keys.empty() ? "" : ", ";
+					keys.append((const char*)data + keyStart, i - keyStart);
+				}
+			}
+			continue;
+		}
+
+		if (depth >= 1 && !std::isspace((unsigned char)c) && !(depth == 1 && (c == '}' || c == ']')))
+			empty = false;
+
+		if (c == '"')
+		{
+			inString = true;
+			isKey = depth == 1 && expectingKey;
+			keyStart = i + 1;
+			if (isKey)
+			{
+				members++;
+				expectingKey = false;
+			}
+		}
+		else if (c == '{' || c == '[')
+		{
+			depth++;
+		}
+		else if (c == '}' || c == ']')
+		{
+			if (--depth == 0)
+				break;
+		}
+		else if (c == ',' && depth == 1)
+		{
+			expectingKey = object;
+			members += object ? 0 : 1;
+		}
+	}
+
+	bool complete = i < length;
+	std::string more = complete ? "" : "+";
+
+	if (object)
+	{
+		preview.format = "JSON object";
+		preview.details.push_back(std::to_string(members) + more + " keys");
+		if (!keys.empty())
+			preview.details.push_back(keys + (members > previewJsonKeys || !complete ? ", ..." : ""));
+	}
+	else
+	{
+		preview.format = "JSON array";
+		preview.details.push_back(std::to_string(empty && members == 0 ? 0 : members + 1) + more + " elements");
+	}
+
+	return true;
+}
+
+// The first lines of a text file, or a hex dump of the first bytes of anything else.
+static void FormatHead(ImFileDialogPreviewData& preview, const uint8_t* data, size_t size)
+{
+	size_t length = std::min(size, previewHeadBytes);
+	size_t control = 0;
+	bool binary = false;
+
+	for (size_t i = 0; i < length && !binary; ++i)
+	{
+		binary = data[i] == 0;
+		control += data[i] < 0x20 && data[i] != '\t' && data[i] != '\n' && data[i] != '\r' && data[i] != '\f' && data[i] != 0x1B;
+	}
+
+	if (!binary && control * 10 <= length)
+	{
+		if (preview.format.empty())
+			preview.format = "Text";
+
+		size_t lines = 0;
+		for (size_t i = 0; i < length && lines < previewHeadLines; ++i)
+		{
+			if (data[i] == '\r')
+				continue;
+			preview.head.push_back((char)data[i]);
+			lines += data[i] == '\n';
+		}
+		return;
+	}
+
+	if (preview.format.empty())
+		preview.format = "Binary";
+
+	length = std::min(size, previewHexBytes);
+	for (size_t line = 0; line < length; line += 16)
+	{
+		char text[96];
+		int written = std::snprintf(text, sizeof(text), "%08zx ", line);
+		for (size_t i = line; i < line + 16; ++i)
+			written += i < length ? std::snprintf(text + written, sizeof(text) - written, " %02x", data[i]) : std::snprintf(text + written, sizeof(text) - written, "   ");
+
+		written += std::snprintf(text + written, sizeof(text) - written, "  ");
+		for (size_t i = line; i < line + 16 && i < length; ++i)
+			text[written++] = data[i] >= 0x20 && data[i] < 0x7F ? (char)data[i] : '.';
+
+		preview.head.append(text, written);
+		preview.head.push_back('\n');
+	}
+}
+
+static void InsertPreview(ImFileDialogService* service, std::shared_ptr<const ImFileDialogPreviewData> data, size_t maxBytes)
+{
+	std::lock_guard<std::mutex> lock(service->mutex);
+
+	for (auto it = service->previews.begin(); it != service->previews.end(); ++it)
+	{
+		if ((*it)->path == data->path)
+		{
+			service->previewBytes -= (*it)->bytes;
+			service->previews.erase(it);
+			break;
+		}
+	}
+
+	service->previewBytes += data->bytes;
+	service->previews.push_front(std::move(data));
+
+	while (!service->previews.empty() && service->previewBytes > maxBytes)
+	{
+		service->previewBytes -= service->previews.back()->bytes;
+		service->previews.pop_back();
+	}
+}
+
+static void LoadPreview(std::shared_ptr<ImFileDialogPreview> preview, std::shared_ptr<ImFileDialogService> service, size_t cacheMaxBytes)
+{
+	// The selection may have moved on while the task was queued.
+	if (preview->cancelled)
+		return;
+
+	auto data = std::make_shared<ImFileDialogPreviewData>();
+	data->path = preview->path;
+
+	std::error_code error;
+	data->lastWriteTime = std::filesystem::last_write_time(preview->path, error);
+
+	ImFileDialogMappedFile file;
+	if (!MapFile(file, preview->path, error))
+	{
+		data->error = error.message();
+	}
+	else
+	{
+		data->fileSize = file.size;
+		if (!DescribeImage(*data, file.data, file.size) && !DescribeArchive(*data, file.data, file.size, preview->cancelled))
+			DescribeJson(*data, file.data, file.size);
+		FormatHead(*data, file.data, file.size);
+	}
+
+	// A tar walk cut short by cancellation would cache a wrong count.
+	if (preview->cancelled)
+		return;
+
+	data->bytes = sizeof(ImFileDialogPreviewData) + data->path.native().size() + data->format.size() + data->head.size() + data->error.size();
+	for (const std::string& detail : data->details)
+		data->bytes += sizeof(std::string) + detail.size();
+
+	if (data->error.empty())
+		InsertPreview(service.get(), data, cacheMaxBytes);
+	preview->data = std::move(data);
+	preview->finished = true;
+}
+
+static void CancelPreview(ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->preview)
+	{
+		dialogInfo->preview->cancelled = true;
+		dialogInfo->preview.reset();
+	}
+}
+
+// Shows the preview of `path`, from the cache when it is still current and otherwise read on the
+// worker pool. An unknown write time accepts any cached preview of the path.
+static void UpdatePreview(ImFileDialogInfo* dialogInfo, const std::filesystem::path& path, std::filesystem::file_time_type lastWriteTime)
+{
+	if (path.empty())
+	{
+		CancelPreview(dialogInfo);
+		return;
+	}
+
+	if (dialogInfo->preview && dialogInfo->preview->path == path)
+		return;
+
+	CancelPreview(dialogInfo);
+
+	auto preview = std::make_shared<ImFileDialogPreview>();
+	preview->path = path;
+	dialogInfo->preview = preview;
+
+	const std::shared_ptr<ImFileDialogService>& service = ServiceOf(dialogInfo);
+	{
+		std::lock_guard<std::mutex> lock(service->mutex);
+		for (auto it = service->previews.begin(); it != service->previews.end(); ++it)
+		{
+			if ((*it)->path == path && (lastWriteTime == ImFileDialogEntryList::unknownTime || (*it)->lastWriteTime == lastWriteTime))
+			{
+				preview->data = *it;
+				preview->finished = true;
+				service->previews.splice(service->previews.begin(), service->previews, it);
+				return;
+			}
+		}
+	}
+
+	SubmitTask(service, [preview, service, cacheMaxBytes = dialogInfo->previewCacheMaxBytes]() { LoadPreview(preview, service, cacheMaxBytes); });
+}
+
+static void DrawPreview(const ImFileDialogInfo* dialogInfo, const ImVec4& textErrorColor)
+{
+	const ImFileDialogPreview* preview = dialogInfo->preview.get();
+	if (!preview)
+	{
+		ImGui::TextDisabled("No file selected");
+		return;
+	}
+
+	ImGui::TextUnformatted(preview->path.filename().string().c_str());
+
+	if (!preview->finished)
+	{
+		ImGui::TextDisabled("Loading preview...");
+		return;
+	}
+
+	const ImFileDialogPreviewData& data = *preview->data;
+	if (!data.error.empty())
+	{
+		ImGui::TextColored(textErrorColor, "%s", data.error.c_str());
+		return;
+	}
+
+	ImGui::TextDisabled("%s, %s bytes", data.format.c_str(), FormatSize(data.fileSize).c_str());
+	for (const std::string& detail : data.details)
+		ImGui::TextWrapped("%s", detail.c_str());
+
+	ImGui::Separator();
+	ImGui::TextUnformatted(data.head.data(), data.head.data() + data.head.size());
+}
+
+static void CloseListing(ImFileDialogInfo* dialogInfo)
+{
+	StoreListing(dialogInfo);
+	CancelScan(dialogInfo);
+	CancelWalk(dialogInfo);
+	dialogInfo->watch.reset();
+
+	dialogInfo->backHistory.clear();
+	dialogInfo->forwardHistory.clear();
+
+	dialogInfo->scannedPath.clear();
+	dialogInfo->refreshInfo = false;
+	dialogInfo->currentIndex = 0;
+	dialogInfo->currentFiles.clear();
+	dialogInfo->currentDirectories.clear();
+	dialogInfo->searchQuery.clear();
+	dialogInfo->search.reset();
+	ClearSelection(dialogInfo);
+	CancelMetadata(dialogInfo);
+	CancelFolderSizes(dialogInfo);
+	CancelColumnValues(dialogInfo);
+	CancelPreview(dialogInfo);
+	CancelSpeculation(dialogInfo);
+	dialogInfo->pathBar.reset();
+	dialogInfo->tree.reset();
+	dialogInfo->listingCheck.reset();
+	dialogInfo->navigationCheck.reset();
+	dialogInfo->confirmCheck.reset();
+}
+
+// Resets the sort orders and closes the listing once the dialog has its result.
+static void CloseDialog(ImFileDialogInfo* dialogInfo, bool* open)
+{
+	dialogInfo->fileNameSortOrder = ImGuiFileDialogSortOrder_None;
+	dialogInfo->sizeSortOrder = ImGuiFileDialogSortOrder_None;
+	dialogInfo->typeSortOrder = ImGuiFileDialogSortOrder_None;
+	dialogInfo->dateSortOrder = ImGuiFileDialogSortOrder_None;
+	ClearColumnSortOrders(dialogInfo);
+
+	CloseListing(dialogInfo);
+
+	*open = false;
+}
+
+// Takes the confirm check once the worker is done with it.
+static std::shared_ptr<ImFileDialogPathCheck> TakeConfirmCheck(ImFileDialogInfo* dialogInfo)
+{
+	if (!dialogInfo->confirmCheck || !dialogInfo->confirmCheck->finished)
+		return nullptr;
+
+	return std::move(dialogInfo->confirmCheck);
+}
+
+static void AddCounters(ImFileDialogCounters& total, const ImFileDialogCounters& frame)
+{
+	total.scanMs += frame.scanMs;
+	total.filterMs += frame.filterMs;
+	total.sortMs += frame.sortMs;
+	total.drawMs += frame.drawMs;
+	total.filesystemCalls += frame.filesystemCalls;
+	total.scannedEntries += frame.scannedEntries;
+}
+
+// Debug overlay in the top right corner of the dialog with the counters of the current frame.
+static void DrawStats(const ImFileDialogInfo* dialogInfo)
+{
+	const ImFileDialogStats& stats = dialogInfo->stats;
+	const ImFileDialogCounters& frame = stats.frame;
+
+	char text[512];
+	std::snprintf(text, sizeof(text),
+		"scan %.3f ms  filter %.3f ms  sort %.3f ms  draw %.3f ms\n"
+		"filesystem calls %llu (total %llu)\n"
+		"scanned %llu (total %llu)  listed %zu  displayed %zu  rows %zu\n"
+		"last scan %.1f ms  frames %llu",
+		frame.scanMs, frame.filterMs, frame.sortMs, frame.drawMs,
+		(unsigned long long)frame.filesystemCalls, (unsigned long long)stats.total.filesystemCalls,
+		(unsigned long long)frame.scannedEntries, (unsigned long long)stats.total.scannedEntries, stats.listedEntries, stats.displayedEntries, stats.drawnRows,
+		stats.lastScanMs, (unsigned long long)stats.frames);
+
+	const ImVec2 padding = ImGui::GetStyle().WindowPadding;
+	ImVec2 textSize = ImGui::CalcTextSize(text);
+	ImVec2 windowPos = ImGui::GetWindowPos();
+
+	ImVec2 max(windowPos.x + ImGui::GetWindowWidth() - padding.x, windowPos.y + ImGui::GetFrameHeight() + padding.y * 3.0f + textSize.y);
+	ImVec2 min(max.x - textSize.x - padding.x * 2.0f, windowPos.y + ImGui::GetFrameHeight() + padding.y);
+
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	drawList->AddRectFilled(min, max, IM_COL32(0, 0, 0, 200), 4.0f);
+	drawList->AddText(ImVec2(min.x + padding.x, min.y + padding.y), IM_COL32(255, 255, 255, 255), text);
+}
+
+static int PathBarCallback(ImGuiInputTextCallbackData* data)
+{
+	ImFileDialogInfo* dialogInfo = (ImFileDialogInfo*)data->UserData;
+	ImFileDialogPathBar* pathBar = dialogInfo->pathBar.get();
+	std::string text(data->Buf, data->BufTextLen);
+
+	if (data->EventFlag == ImGuiInputTextFlags_CallbackCompletion && CompletePath(dialogInfo, pathBar, text))
+	{
+		data->DeleteChars(0, data->BufTextLen);
+		data->InsertChars(0, text.c_str());
+	}
+
+	pathBar->text = text;
+	pathBar->editing = true;
+	pathBar->notFound = false;
+	return 0;
+}
+
+// Draws the path as an editable field. Enter opens the typed folder, Tab completes it, and the
+// folders matching the typed name are listed below while it is edited.
+static void DrawPathBar(ImFileDialogInfo* dialogInfo, const ImVec4& textErrorColor)
+{
+	if (!dialogInfo->pathBar)
+		dialogInfo->pathBar = std::make_shared<ImFileDialogPathBar>();
+
+	ImFileDialogPathBar* pathBar = dialogInfo->pathBar.get();
+	if (!pathBar->editing)
+		pathBar->text = dialogInfo->directoryPath.string();
+
+	char pathBuffer[pathBufferSize];
+	size_t pathSize = std::min(pathBar->text.size(), pathBufferSize - 1);
+	std::memcpy(pathBuffer, pathBar->text.c_str(), pathSize);
+	pathBuffer[pathSize] = 0;
+
+	ImGui::AlignTextToFramePadding();
+	ImGui::TextUnformatted("Path:");
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.6f);
+
+	ImGuiInputTextFlags flags = ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CallbackCompletion | ImGuiInputTextFlags_CallbackEdit;
+	if (ImGui::InputText("##Path", pathBuffer, pathBufferSize, flags, PathBarCallback, dialogInfo))
+	{
+		std::filesystem::path directoryPath = pathBar->text;
+		if (directoryPath.has_relative_path() && !directoryPath.has_filename())
+			directoryPath = directoryPath.parent_path();
+
+		// Whether the folder exists is read on a worker; UpdatePathChecks opens it or reports it missing.
+		if (directoryPath != dialogInfo->directoryPath)
+			dialogInfo->navigationCheck = StartPathCheck(dialogInfo, directoryPath);
+		else
+			pathBar->editing = false;
+	}
+
+	// Clicking a suggestion takes the focus from the field, so the list outlives it by one frame.
+	if (ImGui::IsItemDeactivated() && !pathBar->suggestionsHovered && !pathBar->notFound)
+		pathBar->editing = false;
+
+	if (pathBar->notFound)
+	{
+		ImGui::SameLine();
+		ImGui::TextColored(textErrorColor, "No such folder");
+	}
+}
+
+// Lists the sub-folders matching the partial name typed into the path bar. Clicking one opens it.
+static void DrawPathSuggestions(ImFileDialogInfo* dialogInfo)
+{
+	ImFileDialogPathBar* pathBar = dialogInfo->pathBar.get();
+	pathBar->suggestionsHovered = false;
+
+	if (!pathBar->editing)
+		return;
+
+	std::filesystem::path directoryPath;
+	std::string prefix;
+	SplitPathText(pathBar->text, directoryPath, prefix);
+	UpdatePathIndex(dialogInfo, pathBar, directoryPath);
+
+	if (!pathBar->indexReady)
+	{
+		if (pathBar->indexRequested)
+			ImGui::TextDisabled("Listing %s...", directoryPath.string().c_str());
+		return;
+	}
+
+	std::pair<size_t, size_t> range = FindPathSuggestions(pathBar, prefix);
+	size_t count = std::min(range.second - range.first, pathSuggestionsMax);
+	if (count == 0)
+		return;
+
+	size_t rows = count + (range.second - range.first > count ? 1 : 0);
+	float height = ImGui::GetTextLineHeightWithSpacing() * rows + ImGui::GetStyle().WindowPadding.y * 2.0f;
+	if (ImGui::BeginChild("##pathSuggestions", ImVec2(ImGui::GetContentRegionAvail().x * 0.6f, height), ImGuiChildFlags_Borders))
+	{
+		for (size_t i = range.first; i < range.first + count; ++i)
+		{
+			const std::string& name = pathBar->index[i].second;
+			if (ImGui::Selectable(name.c_str()))
+			{
+				if (dialogInfo->walk)
+					dialogInfo->searchQuery.clear();
+
+				Navigate(dialogInfo, directoryPath / name);
+				pathBar->editing = false;
+			}
+		}
+
+		if (range.second - range.first > count)
+			ImGui::TextDisabled("%zu more", range.second - range.first - count);
+	}
+	pathBar->suggestionsHovered = ImGui::IsWindowHovered();
+	ImGui::EndChild();
+}
+
+// Clicking a place checks it on a worker; UpdatePathChecks opens it, or drops it when it no
+// longer exists.
+static void DrawPlaceList(ImFileDialogInfo* dialogInfo, const char* label, std::vector<std::filesystem::path>& places)
+{
+	if (places.empty())
+		return;
+
+	ImGui::SeparatorText(label);
+	ImGui::PushID(label);
+
+	for (size_t i = 0; i < places.size(); ++i)
+	{
+		const std::filesystem::path& place = places[i];
+		std::string name = place.has_filename() ? place.filename().string() : place.string();
+
+		ImGui::PushID((int)i);
+		if (ImGui::Selectable(name.c_str(), place == dialogInfo->directoryPath) && place != dialogInfo->directoryPath)
+		{
+			dialogInfo->navigationCheck = StartPathCheck(dialogInfo, place);
+			dialogInfo->navigationCheck->places = &places;
+		}
+		ImGui::SetItemTooltip("%s", place.string().c_str());
+		ImGui::PopID();
+	}
+
+	ImGui::PopID();
+}
+
+static void DrawPlaces(ImFileDialogInfo* dialogInfo)
+{
+	if (ImGui::BeginChild("##places", ImVec2(placesWidth, 300), ImGuiChildFlags_Borders))
+	{
+		bool changed = false;
+		auto bookmark = std::find(dialogInfo->bookmarks.begin(), dialogInfo->bookmarks.end(), dialogInfo->directoryPath);
+
+		if (ImGui::SmallButton(bookmark != dialogInfo->bookmarks.end() ? "Remove bookmark" : "Bookmark folder"))
+		{
+			if (bookmark != dialogInfo->bookmarks.end())
+				dialogInfo->bookmarks.erase(bookmark);
+			else
+				dialogInfo->bookmarks.push_back(dialogInfo->directoryPath);
+			changed = true;
+		}
+
+		DrawPlaceList(dialogInfo, "Bookmarks", dialogInfo->bookmarks);
+		DrawPlaceList(dialogInfo, "Recent", dialogInfo->recentDirectories);
+
+		if (changed)
+			SavePlaces(dialogInfo);
+	}
+	ImGui::EndChild();
+}
+
+// Only the rows in view are submitted, so the cost of a frame does not grow with the tree.
+static void DrawTree(ImFileDialogInfo* dialogInfo)
+{
+	if (ImGui::BeginChild("##tree", ImVec2(treeWidth, 300), ImGuiChildFlags_Borders, ImGuiWindowFlags_HorizontalScrollbar))
+	{
+		ImFileDialogTree* tree = dialogInfo->tree.get();
+		float indentSpacing = ImGui::GetStyle().IndentSpacing;
+		uint32_t toggled = UINT32_MAX;
+		uint32_t clicked = UINT32_MAX;
+
+		ImGuiListClipper clipper;
+		clipper.Begin((int)tree->rows.size());
+
+		// A revealed folder is submitted even when clipped, to scroll it into view.
+		int scrollRow = -1;
+		if (tree->scrollTo != UINT32_MAX)
+		{
+			auto it = std::find(tree->rows.begin(), tree->rows.end(), tree->scrollTo);
+			if (it != tree->rows.end())
+			{
+				scrollRow = (int)(it - tree->rows.begin());
+				clipper.IncludeItemByIndex(scrollRow);
+			}
+			tree->scrollTo = UINT32_MAX;
+		}
+
+		while (clipper.Step())
+		{
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+			{
+				uint32_t index = tree->rows[row];
+				const ImFileDialogTreeNode& node = tree->nodes[index];
+
+				ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanAvailWidth;
+				if (node.listed && node.childCount == 0)
+					flags |= ImGuiTreeNodeFlags_Leaf;
+				if (node.path == dialogInfo->directoryPath)
+					flags |= ImGuiTreeNodeFlags_Selected;
+
+				ImGui::SetCursorPosX(ImGui::GetCursorPosX() + node.depth * indentSpacing);
+				ImGui::SetNextItemOpen(node.expanded);
+				ImGui::TreeNodeEx((void*)(intptr_t)index, flags, "%s%s", node.name.c_str(), node.job ? " ..." : "");
+				if (row == scrollRow && !ImGui::IsItemVisible())
+					ImGui::SetScrollHereY();
+
+				if (ImGui::IsItemToggledOpen())
+					toggled = index;
+				else if (ImGui::IsItemClicked())
+					clicked = index;
+			}
+		}
+
+		if (toggled != UINT32_MAX)
+		{
+			if (tree->nodes[toggled].expanded)
+			{
+				tree->nodes[toggled].expanded = false;
+				tree->rowsStale = true;
+			}
+			else
+			{
+				ExpandTreeNode(dialogInfo, tree, toggled);
+			}
+		}
+
+		if (clicked != UINT32_MAX && tree->nodes[clicked].path != dialogInfo->directoryPath)
+			Navigate(dialogInfo, tree->nodes[clicked].path);
+	}
+	ImGui::EndChild();
+}
+
+// Counts the selected files that are shown; hidden ones stay selected but are not returned.
+// Only needed when the shown files change; selection requests keep the count up to date.
+static size_t CountSelection(const ImFileDialogInfo* dialogInfo)
+{
+	if (dialogInfo->selection.empty())
+		return 0;
+
+	size_t count = 0;
+	for (uint32_t entryIndex : dialogInfo->displayFiles)
+		count += dialogInfo->selection.contains(entryIndex) ? 1 : 0;
+	return count;
+}
+
+// Selects or clears one shown file, keeping the count of selected ones.
+static void SetSelected(ImFileDialogInfo* dialogInfo, uint32_t entryIndex, bool selected)
+{
+	if (dialogInfo->selection.contains(entryIndex) == selected)
+		return;
+
+	dialogInfo->selection.set(entryIndex, selected);
+	if (selected)
+		dialogInfo->selectedCount++;
+	else
+		dialogInfo->selectedCount--;
+}
+
+// Applies the requests of a multi-select scope whose items are table rows. Only file rows take
+// part; selecting everything while nothing is filtered out stays O(1), and covers only the
+// files listed so far.
+static void ApplySelectionRequests(ImFileDialogInfo* dialogInfo, const ImGuiMultiSelectIO* io, size_t listedFiles, size_t directoryRowsEnd)
+{
+	ImFileDialogSelection& selection = dialogInfo->selection;
+	const std::vector<uint32_t>& displayFiles = dialogInfo->displayFiles;
+
+	for (const ImGuiSelectionRequest& request : io->Requests)
+	{
+		if (request.Type == ImGuiSelectionRequestType_SetAll)
+		{
+			if (!request.Selected)
+			{
+				selection.clear();
+				dialogInfo->selectedCount = 0;
+			}
+			else if (displayFiles.size() == listedFiles)
+			{
+				selection.selectAll(listedFiles);
+				dialogInfo->selectedCount = listedFiles;
+			}
+			else
+			{
+				for (uint32_t entryIndex : displayFiles)
+					SetSelected(dialogInfo, entryIndex, true);
+			}
+		}
+		else if (request.Type == ImGuiSelectionRequestType_SetRange)
+		{
+			ImGuiSelectionUserData first = std::max<ImGuiSelectionUserData>(request.RangeFirstItem, (ImGuiSelectionUserData)directoryRowsEnd);
+			ImGuiSelectionUserData last = std::min<ImGuiSelectionUserData>(request.RangeLastItem, (ImGuiSelectionUserData)(directoryRowsEnd + displayFiles.size()) - 1);
+
+			for (ImGuiSelectionUserData row = first; row <= last; ++row)
+				SetSelected(dialogInfo, displayFiles[(size_t)row - directoryRowsEnd], request.Selected);
+		}
+	}
+}
+
+// The shown files that are selected, in the order they are shown.
+static std::vector<std::filesystem::path> SelectedPaths(const ImFileDialogInfo* dialogInfo)
+{
+	const ImFileDialogEntryList& files = dialogInfo->walk ? dialogInfo->walk->files : dialogInfo->currentFiles;
+	std::vector<std::filesystem::path> paths;
+	paths.reserve(dialogInfo->selectedCount);
+
+	for (uint32_t entryIndex : dialogInfo->displayFiles)
+	{
+		if (dialogInfo->selection.contains(entryIndex))
+			paths.push_back(files.path(dialogInfo->directoryPath, entryIndex));
+	}
+
+	return paths;
+}
+
+void ImGui::FileDialogPrefetch(ImFileDialogInfo* dialogInfo)
+{
+	assert(dialogInfo != nullptr);
+
+	if (dialogInfo->parsedFilters.empty())
+		ParseFilters(dialogInfo);
+
+	LoadPlaces(dialogInfo);
+
+	if (!dialogInfo->directoryPath.empty())
+		PrefetchListing(dialogInfo, dialogInfo->directoryPath);
+
+	// The recent folders come from the places file; it is waited for as long as a listing is.
+	if (ImFileDialogPlacesLoad* load = dialogInfo->placesLoad.get())
+	{
+		auto timeout = std::chrono::duration<double, std::milli>(std::max(dialogInfo->syncScanTimeoutMs, 0.0));
+		std::unique_lock<std::mutex> lock(load->mutex);
+		load->done.wait_for(lock, timeout, [load]() { return load->finished.load(); });
+	}
+
+	if (!UpdatePlaces(dialogInfo))
+		PrefetchRecent(dialogInfo);
+}
+
+bool ImGui::FileDialog(bool* open, ImFileDialogInfo* dialogInfo)
+{
+	assert(dialogInfo != nullptr);
+
+	if (!*open) return false;
+
+	dialogInfo->stats.frame = ImFileDialogCounters();
+	dialogInfo->stats.drawnRows = 0;
+
+	static const ImVec4 textErrorColor = ImVec4(1.0, 0.0, 0.0, 1.0);
+
+	bool complete = false;
+
+	ImGui::PushID(dialogInfo);
+	ImGui::SetNextWindowSize(ImVec2(740.0f, 410.0f), ImGuiCond_FirstUseEver);
+
+	if (!ImGui::Begin(dialogInfo->title.c_str(), open)) {
+		ImGui::End();
+		ImGui::PopID();
+		return false;
+	}
+
+	if (dialogInfo->parsedFilters.empty())
+		ParseFilters(dialogInfo);
+
+	// Opening: the recent folders are listed in the background while this one loads, and again
+	// once the places file is read.
+	if (dialogInfo->scannedPath.empty())
+	{
+		LoadPlaces(dialogInfo);
+		PrefetchRecent(dialogInfo);
+	}
+	UpdatePlaces(dialogInfo);
+
+	if (dialogInfo->refreshInfo || dialogInfo->scannedPath != dialogInfo->directoryPath)
+	{
+		// A watch already on the folder is kept through a reload, so no change goes unseen while
+		// a new one would be added.
+		if (!dialogInfo->watchDirectory)
+			dialogInfo->watch.reset();
+		else if (!dialogInfo->watch || !dialogInfo->watch->ready || dialogInfo->watch->directoryPath != dialogInfo->directoryPath)
+			StartWatch(dialogInfo);
+
+		// A refresh of the directory on screen always rescans; navigation may be served from the cache.
+		// The tree lists the folder again from the new listing, and checks its other folders.
+		bool reload = dialogInfo->scannedPath == dialogInfo->directoryPath;
+		if (!reload)
+			StoreListing(dialogInfo);
+
+		if (reload && dialogInfo->tree)
+		{
+			dialogInfo->tree->refreshedPath = dialogInfo->directoryPath;
+			dialogInfo->tree->nextCheck = std::chrono::steady_clock::time_point();
+		}
+
+		if (reload || (!LoadListing(dialogInfo) && !AdoptSpeculation(dialogInfo)))
+		{
+			if (dialogInfo->asyncScan)
+				StartScan(dialogInfo);
+			else
+				RefreshInfo(dialogInfo);
+		}
+	}
+
+	if (dialogInfo->scan)
+		ConsumeScan(dialogInfo);
+
+	UpdatePathChecks(dialogInfo);
+
+	if (dialogInfo->metadata)
+		ConsumeMetadata(dialogInfo);
+
+	UpdateFolderSizes(dialogInfo);
+
+	UpdateWalk(dialogInfo);
+
+	if (dialogInfo->watch)
+		PollWatch(dialogInfo);
+
+	// Draw history
+	ImGui::BeginDisabled(dialogInfo->backHistory.empty());
+	if (ImGui::ArrowButton("##Back", ImGuiDir_Left))
+	{
+		dialogInfo->forwardHistory.push_back(dialogInfo->directoryPath);
+		dialogInfo->directoryPath = dialogInfo->backHistory.back();
+		dialogInfo->backHistory.pop_back();
+		dialogInfo->refreshInfo = true;
+	}
+	ImGui::EndDisabled();
+	ImGui::SameLine();
+	ImGui::BeginDisabled(dialogInfo->forwardHistory.empty());
+	if (ImGui::ArrowButton("##Forward", ImGuiDir_Right))
+	{
+		dialogInfo->backHistory.push_back(dialogInfo->directoryPath);
+		dialogInfo->directoryPath = dialogInfo->forwardHistory.back();
+		dialogInfo->forwardHistory.pop_back();
+		dialogInfo->refreshInfo = true;
+	}
+	ImGui::EndDisabled();
+	ImGui::SameLine();
+
+	// Draw path
+	DrawPathBar(dialogInfo, textErrorColor);
+
+	if (dialogInfo->scan)
+	{
+		ImFileDialogScan* scan = dialogInfo->scan.get();
+		if (!scan->finished)
+		{
+			ImGui::SameLine();
+			ImGui::TextDisabled("Scanning %zu entries...", scan->scannedEntries);
+			ImGui::SameLine();
+			if (ImGui::SmallButton("Cancel##scan"))
+				StopScan(dialogInfo, std::errc::operation_canceled);
+		}
+		else if (scan->error)
+		{
+			// A stopped or failed listing keeps what it read; say that it is partial.
+			const char* message = scan->error == std::errc::timed_out ? "The folder did not respond in time"
+				: scan->error == std::errc::operation_canceled ? "Listing cancelled"
+				: scan->error == std::errc::value_too_large ? "Listing stopped early" : nullptr;
+			size_t listed = dialogInfo->currentFiles.size() + dialogInfo->currentDirectories.size();
+
+			ImGui::SameLine();
+			if (listed != 0)
+				ImGui::TextColored(textErrorColor, "%s (showing %zu entries)", message ? message : scan->error.message().c_str(), listed);
+			else
+				ImGui::TextColored(textErrorColor, "%s", message ? message : scan->error.message().c_str());
+		}
+
+		if (scan->entryErrors != 0)
+		{
+			ImGui::SameLine();
+			ImGui::TextDisabled("%zu entries could not be read", scan->entryErrors);
+		}
+	}
+
+	if (dialogInfo->metadata && (dialogInfo->metadata->bulkFiles != 0 || dialogInfo->metadata->bulkDirectories != 0))
+	{
+		size_t missing = dialogInfo->currentFiles.missingMetadataCount() + dialogInfo->currentDirectories.missingMetadataCount();
+		if (missing != 0)
+		{
+			ImGui::SameLine();
+			ImGui::TextDisabled("Reading details of %zu entries...", missing);
+		}
+	}
+
+	if (dialogInfo->folderSizes && dialogInfo->folderSizes->pending != 0)
+	{
+		ImGui::SameLine();
+		if (dialogInfo->folderSizes->cancelled)
+		{
+			ImGui::TextDisabled("Folder sizes cancelled");
+		}
+		else
+		{
+			ImGui::TextDisabled("Measuring %zu folders...", dialogInfo->folderSizes->pending);
+			ImGui::SameLine();
+			if (ImGui::SmallButton("Cancel sizes"))
+				dialogInfo->folderSizes->cancelled = true;
+		}
+	}
+
+	DrawPathSuggestions(dialogInfo);
+
+	// Draw search
+	static const size_t searchBufferSize = 200;
+	char searchBuffer[searchBufferSize];
+
+	size_t searchSize = dialogInfo->searchQuery.size();
+	if (searchSize >= searchBufferSize)	searchSize = searchBufferSize - 1;
+	std::memcpy(searchBuffer, dialogInfo->searchQuery.c_str(), searchSize);
+	searchBuffer[searchSize] = 0;
+
+	const ImGuiStyle& style = ImGui::GetStyle();
+	float checkboxesWidth = ImGui::CalcTextSize("Fuzzy").x + ImGui::CalcTextSize("Subfolders").x + ImGui::CalcTextSize("Natural sort").x + ImGui::CalcTextSize("Folder sizes").x + ImGui::CalcTextSize("Preview").x + (ImGui::GetFrameHeight() + style.ItemInnerSpacing.x + style.ItemSpacing.x) * 5.0f;
+
+	ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x - checkboxesWidth);
+	if (ImGui::InputTextWithHint("##Search", "Search", searchBuffer, searchBufferSize))
+	{
+		dialogInfo->searchQuery = searchBuffer;
+		dialogInfo->currentIndex = 0;
+	}
+	ImGui::PopItemWidth();
+	ImGui::SameLine();
+	if (ImGui::Checkbox("Fuzzy", &dialogInfo->fuzzySearch))
+		dialogInfo->currentIndex = 0;
+	ImGui::SameLine();
+	ImGui::Checkbox("Subfolders", &dialogInfo->recursiveSearch);
+	ImGui::SameLine();
+	if (ImGui::Checkbox("Natural sort", &dialogInfo->naturalSort))
+		dialogInfo->refreshSort = true;
+	ImGui::SameLine();
+	if (ImGui::Checkbox("Folder sizes", &dialogInfo->showFolderSizes))
+		dialogInfo->refreshSort = true;
+	ImGui::SameLine();
+	ImGui::Checkbox("Preview", &dialogInfo->showPreview);
+
+	if (dialogInfo->walk)
+	{
+		ImFileDialogWalk* walk = dialogInfo->walk.get();
+		size_t results = walk->files.size() + walk->directories.size();
+
+		if (!walk->finished)
+		{
+			ImGui::TextDisabled("Searching subfolders: %zu matches in %zu folders...", results, walk->scannedDirectories.load());
+			ImGui::SameLine();
+			if (ImGui::SmallButton("Cancel search"))
+			{
+				walk->cancelled = true;
+				WakeWalkers(walk, true);
+			}
+		}
+		else if (walk->truncated)
+		{
+			ImGui::TextDisabled("Showing the first %zu matches", results);
+		}
+		else if (walk->cancelled)
+		{
+			ImGui::TextDisabled("Search cancelled: %zu matches in %zu folders", results, walk->scannedDirectories.load());
+		}
+		else
+		{
+			ImGui::TextDisabled("%zu matches in %zu folders", results, walk->scannedDirectories.load());
+		}
+	}
+
+	std::filesystem::path previewPath;
+	std::filesystem::file_time_type previewWriteTime = ImFileDialogEntryList::unknownTime;
 
-	std::vector<std::string> actualFilters = dialogInfo->filters;
-	if (actualFilters.empty()) {
-		actualFilters.push_back("All Files (*.*)|.*");
+	float browserWidth = ImGui::GetContentRegionAvail().x;
+	if (dialogInfo->showPreview)
+		browserWidth -= previewWidth + style.ItemSpacing.x;
+
+	// Draw places
+	if (dialogInfo->showPlaces)
+	{
+		browserWidth -= placesWidth + style.ItemSpacing.x;
+
+		DrawPlaces(dialogInfo);
+		ImGui::SameLine();
 	}
 
-	for (size_t i = 0; i < actualFilters.size(); ++i) {
-		std::string activeFilter = actualFilters[i];
-		std::string filterName = activeFilter.substr(0, activeFilter.find("|"));
-		std::string filterExtensions = activeFilter.substr(activeFilter.find("|") + 1);
+	// Draw tree
+	UpdateTree(dialogInfo);
+	if (dialogInfo->tree)
+	{
+		browserWidth -= treeWidth + style.ItemSpacing.x;
 
-		dialogInfo->parsedFilters.insert(filterName, {});
+		DrawTree(dialogInfo);
+		ImGui::SameLine();
+	}
 
-		bool hasWildcard = false;
-		std::vector<std::string> extensions;
+	// Extra columns can be hidden from the header's context menu; hidden ones are not computed.
+	UpdateColumnValues(dialogInfo);
+	ImGuiTableFlags tableFlags = ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_SizingFixedFit;
+	if (!dialogInfo->columns.empty())
+		tableFlags |= ImGuiTableFlags_Hideable;
 
-		size_t pos = 0;
-		while ((pos = filterExtensions.find("|")) != std::string::npos) {
-			std::string ext = filterExtensions.substr(0, pos);
-			filterExtensions.erase(0, pos + 1);
+	if (ImGui::BeginTable("##browser", 4 + (int)dialogInfo->columns.size(), tableFlags, ImVec2(browserWidth, 300)))
+	{
+		// Columns size
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_NoHide, 230.0f);
+		ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+		ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+		ImGui::TableSetupColumn("Date", ImGuiTableColumnFlags_WidthStretch);
+		for (const ImFileDialogColumn& column : dialogInfo->columns)
+			ImGui::TableSetupColumn(column.name.c_str(), ImGuiTableColumnFlags_WidthFixed, column.width);
 
-			if (ext == ".*") {
-				hasWildcard = true;
-				break;
+		// File Columns
+		ImGui::TableNextRow(ImGuiTableRowFlags_Headers);
+		if (DrawHeaderCell("Name"))
+		{
+			dialogInfo->sizeSortOrder = ImGuiFileDialogSortOrder_None;
+			dialogInfo->dateSortOrder = ImGuiFileDialogSortOrder_None;
+			dialogInfo->typeSortOrder = ImGuiFileDialogSortOrder_None;
+			ClearColumnSortOrders(dialogInfo);
+			dialogInfo->fileNameSortOrder = dialogInfo->fileNameSortOrder == ImGuiFileDialogSortOrder_Down ? ImGuiFileDialogSortOrder_Up : ImGuiFileDialogSortOrder_Down;
+			dialogInfo->refreshSort = true;
+		}
+		if (DrawHeaderCell("Size"))
+		{
+			dialogInfo->fileNameSortOrder = ImGuiFileDialogSortOrder_None;
+			dialogInfo->dateSortOrder = ImGuiFileDialogSortOrder_None;
+			dialogInfo->typeSortOrder = ImGuiFileDialogSortOrder_None;
+			ClearColumnSortOrders(dialogInfo);
+			dialogInfo->sizeSortOrder = dialogInfo->sizeSortOrder == ImGuiFileDialogSortOrder_Down ? ImGuiFileDialogSortOrder_Up : ImGuiFileDialogSortOrder_Down;
+			dialogInfo->refreshSort = true;
+		}
+		if (DrawHeaderCell("Type"))
+		{
+			dialogInfo->fileNameSortOrder = ImGuiFileDialogSortOrder_None;
+			dialogInfo->dateSortOrder = ImGuiFileDialogSortOrder_None;
+			dialogInfo->sizeSortOrder = ImGuiFileDialogSortOrder_None;
+			ClearColumnSortOrders(dialogInfo);
+			dialogInfo->typeSortOrder = dialogInfo->typeSortOrder == ImGuiFileDialogSortOrder_Down ? ImGuiFileDialogSortOrder_Up : ImGuiFileDialogSortOrder_Down;
+			dialogInfo->refreshSort = true;
+		}
+		if (DrawHeaderCell("Date"))
+		{
+			dialogInfo->fileNameSortOrder = ImGuiFileDialogSortOrder_None;
+			dialogInfo->sizeSortOrder = ImGuiFileDialogSortOrder_None;
+			dialogInfo->typeSortOrder = ImGuiFileDialogSortOrder_None;
+			ClearColumnSortOrders(dialogInfo);
+			dialogInfo->dateSortOrder = dialogInfo->dateSortOrder == ImGuiFileDialogSortOrder_Down ? ImGuiFileDialogSortOrder_Up : ImGuiFileDialogSortOrder_Down;
+			dialogInfo->refreshSort = true;
+		}
+		for (size_t column = 0; column < dialogInfo->columns.size(); ++column)
+		{
+			ImGui::PushID((int)column);
+			if (DrawHeaderCell(dialogInfo->columns[column].name.c_str()))
+			{
+				ImGuiFileDialogSortOrder sortOrder = dialogInfo->columns[column].sortOrder;
+				dialogInfo->fileNameSortOrder = ImGuiFileDialogSortOrder_None;
+				dialogInfo->sizeSortOrder = ImGuiFileDialogSortOrder_None;
+				dialogInfo->typeSortOrder = ImGuiFileDialogSortOrder_None;
+				dialogInfo->dateSortOrder = ImGuiFileDialogSortOrder_None;
+				ClearColumnSortOrders(dialogInfo);
+				dialogInfo->columns[column].sortOrder = sortOrder == ImGuiFileDialogSortOrder_Down ? ImGuiFileDialogSortOrder_Up : ImGuiFileDialogSortOrder_Down;
+				dialogInfo->refreshSort = true;
 			}
+			ImGui::PopID();
+		}
 
-			extensions.push_back(ext);
+		// Sorting by size or date reads the details of every entry first, then sorts once more
+		// when the last of them has arrived.
+		if (!dialogInfo->walk && (dialogInfo->sizeSortOrder != ImGuiFileDialogSortOrder_None || dialogInfo->dateSortOrder != ImGuiFileDialogSortOrder_None))
+		{
+			if (dialogInfo->currentFiles.missingMetadataCount() + dialogInfo->currentDirectories.missingMetadataCount() != 0)
+				RequestAllMetadata(dialogInfo);
+			else if (dialogInfo->metadata && dialogInfo->metadata->sortStale)
+				dialogInfo->refreshSort = true;
 		}
 
-		if (!hasWildcard && !filterExtensions.empty()) {
-			std::string ext = filterExtensions;
+		if (dialogInfo->metadata && dialogInfo->currentFiles.missingMetadataCount() + dialogInfo->currentDirectories.missingMetadataCount() == 0)
+			dialogInfo->metadata->sortStale = false;
 
-			if (ext == ".*") {
-				hasWildcard = true;
-			}
-			else {
-				extensions.push_back(ext);
-			}
+		// Likewise for an expensive extra column.
+		size_t valueSortColumn = SIZE_MAX;
+		for (size_t column = 0; column < dialogInfo->columns.size() && valueSortColumn == SIZE_MAX; ++column)
+		{
+			if (dialogInfo->columns[column].sortOrder != ImGuiFileDialogSortOrder_None)
+				valueSortColumn = column;
 		}
 
-		if (hasWildcard) {
-			dialogInfo->parsedFilters[filterName].push_back("*");
+		bool valueSortDescending = valueSortColumn != SIZE_MAX && dialogInfo->columns[valueSortColumn].sortOrder == ImGuiFileDialogSortOrder_Down;
+		if (valueSortColumn != SIZE_MAX && dialogInfo->columnValues && dialogInfo->columnValues->providers[valueSortColumn])
+		{
+			if (!RequestAllColumnValues(dialogInfo, valueSortColumn) && dialogInfo->columnValues->sortStale)
+			{
+				dialogInfo->columnValues->sortStale = false;
+				dialogInfo->refreshSort = true;
+			}
 		}
-		else {
-			dialogInfo->parsedFilters[filterName].insert(dialogInfo->parsedFilters[filterName].end(), extensions.begin(), extensions.end());
 
-			if (dialogInfo->parsedFilters[filterName].empty())
-				dialogInfo->parsedFilters.remove(filterName);
-		}
-	}
-}
+		// Sort directories
+		auto* directories = dialogInfo->walk ? &dialogInfo->walk->directories : &dialogInfo->currentDirectories;
 
-void RefreshInfo(ImFileDialogInfo* dialogInfo)
-{
-	dialogInfo->refreshInfo = false;
-	dialogInfo->currentIndex = 0;
-	dialogInfo->currentFiles.clear();
-	dialogInfo->currentDirectories.clear();
+		ImGuiFileDialogSortColumn nameSortColumn = dialogInfo->naturalSort ? ImGuiFileDialogSortColumn_NaturalName : ImGuiFileDialogSortColumn_Name;
+		ImGuiFileDialogSortColumn directorySortColumn = ImGuiFileDialogSortColumn_None;
+		bool directorySortDescending = false;
 
-	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dialogInfo->directoryPath))
-	{
-		if (entry.is_directory())
+		if (valueSortColumn != SIZE_MAX)
 		{
-			dialogInfo->currentDirectories.push_back(entry);
+			directorySortColumn = ImGuiFileDialogSortColumn_Value;
+			directorySortDescending = valueSortDescending;
 		}
-		else
+		else if (dialogInfo->sizeSortOrder != ImGuiFileDialogSortOrder_None && dialogInfo->folderSizes)
+		{
+			directorySortColumn = ImGuiFileDialogSortColumn_Size;
+			directorySortDescending = dialogInfo->sizeSortOrder == ImGuiFileDialogSortOrder_Down;
+		}
+		else if (dialogInfo->fileNameSortOrder != ImGuiFileDialogSortOrder_None || dialogInfo->sizeSortOrder != ImGuiFileDialogSortOrder_None || dialogInfo->typeSortOrder != ImGuiFileDialogSortOrder_None)
+		{
+			directorySortColumn = nameSortColumn;
+			directorySortDescending = dialogInfo->fileNameSortOrder == ImGuiFileDialogSortOrder_Down;
+		}
+		else if (dialogInfo->dateSortOrder != ImGuiFileDialogSortOrder_None)
 		{
-			if (dialogInfo->type != ImGuiFileDialogType_::ImGuiFileDialogType_SelectFolder) {
-				std::string extension = entry.path().extension().string();
-				bool validExtension = false;
+			directorySortColumn = ImGuiFileDialogSortColumn_Date;
+			directorySortDescending = dialogInfo->dateSortOrder == ImGuiFileDialogSortOrder_Down;
+		}
 
-				if (dialogInfo->parsedFilters.size() > 0) {
-					std::vector extensions = dialogInfo->parsedFilters.at(dialogInfo->currentFilterIndex);
-					for (size_t i = 0; i < extensions.size(); ++i)
-					{
-						if (extensions[i] == "*" || extensions[i] == extension)
-						{
-							validExtension = true;
-							break;
-						}
-					}
-				}
-				else {
-					validExtension = true;
-				}
+		// Folder sizes arrive one by one; the few folders are sorted again as each lands.
+		bool resortDirectories = dialogInfo->folderSizes && dialogInfo->folderSizes->sortStale && directorySortColumn == ImGuiFileDialogSortColumn_Size;
+		if (dialogInfo->folderSizes)
+			dialogInfo->folderSizes->sortStale = false;
 
-				if (validExtension)
-				{
-					dialogInfo->currentFiles.push_back(entry);
-				}
-			}
+		// Extra column values are gathered only when the order is about to be rebuilt or extended.
+		std::vector<std::string> sortValues;
+		{
+			ImFileDialogTimer timer{ dialogInfo->stats.frame.sortMs };
+			bool rebuild = dialogInfo->refreshSort || resortDirectories;
+			if (directorySortColumn == ImGuiFileDialogSortColumn_Value && (rebuild || dialogInfo->sortedDirectories.size() != directories->size()))
+				ColumnSortValues(dialogInfo, valueSortColumn, *directories, true, sortValues);
+
+			if (UpdateSortOrder(dialogInfo->sortedDirectories, *directories, rebuild, directorySortColumn, directorySortDescending, &sortValues))
+				dialogInfo->refreshDisplay = true;
 		}
-	}
-}
 
-bool ImGui::FileDialog(bool* open, ImFileDialogInfo* dialogInfo)
-{
-	if (!*open) return false;
+		// Sort files
+		auto* files = dialogInfo->walk ? &dialogInfo->walk->files : &dialogInfo->currentFiles;
 
-	static float initialSpacingColumn0 = 230.0f;
-	static float initialSpacingColumn1 = 80.0f;
-	static float initialSpacingColumn2 = 90.0f;
-	static ImGuiFileDialogSortOrder fileNameSortOrder = ImGuiFileDialogSortOrder_None;
-	static ImGuiFileDialogSortOrder sizeSortOrder = ImGuiFileDialogSortOrder_None;
-	static ImGuiFileDialogSortOrder dateSortOrder = ImGuiFileDialogSortOrder_None;
-	static ImGuiFileDialogSortOrder typeSortOrder = ImGuiFileDialogSortOrder_None;
+		ImGuiFileDialogSortColumn fileSortColumn = ImGuiFileDialogSortColumn_None;
+		bool fileSortDescending = false;
 
-	static ImVec4 textErrorColor = ImVec4(1.0, 0.0, 0.0, 1.0);
+		if (valueSortColumn != SIZE_MAX)
+		{
+			fileSortColumn = ImGuiFileDialogSortColumn_Value;
+			fileSortDescending = valueSortDescending;
+		}
+		else if (dialogInfo->fileNameSortOrder != ImGuiFileDialogSortOrder_None)
+		{
+			fileSortColumn = nameSortColumn;
+			fileSortDescending = dialogInfo->fileNameSortOrder == ImGuiFileDialogSortOrder_Down;
+		}
+		else if (dialogInfo->sizeSortOrder != ImGuiFileDialogSortOrder_None)
+		{
+			fileSortColumn = ImGuiFileDialogSortColumn_Size;
+			fileSortDescending = dialogInfo->sizeSortOrder == ImGuiFileDialogSortOrder_Down;
+		}
+		else if (dialogInfo->typeSortOrder != ImGuiFileDialogSortOrder_None)
+		{
+			fileSortColumn = ImGuiFileDialogSortColumn_Type;
+			fileSortDescending = dialogInfo->typeSortOrder == ImGuiFileDialogSortOrder_Down;
+		}
+		else if (dialogInfo->dateSortOrder != ImGuiFileDialogSortOrder_None)
+		{
+			fileSortColumn = ImGuiFileDialogSortColumn_Date;
+			fileSortDescending = dialogInfo->dateSortOrder == ImGuiFileDialogSortOrder_Down;
+		}
 
-	static bool folderSelectError = false;
-	static bool fileChooseError = false;
+		{
+			ImFileDialogTimer timer{ dialogInfo->stats.frame.sortMs };
+			if (fileSortColumn == ImGuiFileDialogSortColumn_Value && (dialogInfo->refreshSort || dialogInfo->sortedFiles.size() != files->size()))
+				ColumnSortValues(dialogInfo, valueSortColumn, *files, false, sortValues);
 
-	assert(dialogInfo != nullptr);
+			if (UpdateSortOrder(dialogInfo->sortedFiles, *files, dialogInfo->refreshSort, fileSortColumn, fileSortDescending, &sortValues))
+				dialogInfo->refreshDisplay = true;
+			dialogInfo->refreshSort = false;
+		}
 
-	bool complete = false;
+		// Filter files
+		{
+			ImFileDialogTimer timer{ dialogInfo->stats.frame.filterMs };
 
-	ImGui::PushID(dialogInfo);
-	ImGui::SetNextWindowSize(ImVec2(740.0f, 410.0f), ImGuiCond_FirstUseEver);
+			// Subtree search results already match the query.
+			if (!dialogInfo->walk && UpdateSearch(dialogInfo))
+				dialogInfo->refreshDisplay = true;
 
-	if (!ImGui::Begin(dialogInfo->title.c_str(), open)) {
-		ImGui::End();
-		ImGui::PopID();
-		return false;
-	}
+			if (dialogInfo->refreshDisplay)
+			{
+				const ImFileDialogFilter* filter = nullptr;
+				if (dialogInfo->currentFilterIndex < dialogInfo->parsedFilters.size())
+					filter = &dialogInfo->parsedFilters.at(dialogInfo->currentFilterIndex);
 
-	if (dialogInfo->parsedFilters.empty())
-		ParseFilters(dialogInfo);
+				const ImFileDialogSearch* search = dialogInfo->walk ? nullptr : dialogInfo->search.get();
+				UpdateDisplay(dialogInfo->displayDirectories, dialogInfo->sortedDirectories, *directories, nullptr, 0, search ? &search->directories.matched : nullptr);
+				UpdateDisplay(dialogInfo->displayFiles, dialogInfo->sortedFiles, *files, filter, dialogInfo->currentFilterIndex, search ? &search->files.matched : nullptr);
+				dialogInfo->selectedCount = CountSelection(dialogInfo);
+				dialogInfo->refreshDisplay = false;
+			}
+		}
 
-	if (dialogInfo->currentFiles.empty() && dialogInfo->currentDirectories.empty() || dialogInfo->refreshInfo)
-		RefreshInfo(dialogInfo);
+		dialogInfo->stats.listedEntries = files->size() + directories->size();
+		dialogInfo->stats.displayedEntries = dialogInfo->displayFiles.size() + dialogInfo->displayDirectories.size();
 
-	// Draw path
-	ImGui::Text("Path: %s", dialogInfo->directoryPath.string().c_str());
+		// Only the rows inside the visible part of the table are submitted.
+		// Row indices follow the old layout: parent, directories, files.
+		size_t parentRows = dialogInfo->directoryPath.has_parent_path() ? 1 : 0;
+		size_t directoryRowsEnd = parentRows + dialogInfo->displayDirectories.size();
+		size_t rowCount = directoryRowsEnd + dialogInfo->displayFiles.size();
 
-	ImGui::BeginChild("##browser", ImVec2(ImGui::GetContentRegionAvail().x, 300), ImGuiChildFlags_Borders, ImGuiWindowFlags_HorizontalScrollbar);
-	ImGui::Columns(4);
+		ImFileDialogTimer drawTimer{ dialogInfo->stats.frame.drawMs };
+		std::deque<ImFileDialogMetadataRequest> metadataRequests;
+		std::deque<ImFileDialogColumnRequest> columnRequests;
+		std::filesystem::path hoveredDirectory;
 
-	// Columns size
-	if (initialSpacingColumn0 > 0)
-	{
-		ImGui::SetColumnWidth(0, initialSpacingColumn0);
-		initialSpacingColumn0 = 0.0f;
-	}
-	if (initialSpacingColumn1 > 0)
-	{
-		ImGui::SetColumnWidth(1, initialSpacingColumn1);
-		initialSpacingColumn1 = 0.0f;
-	}
-	if (initialSpacingColumn2 > 0)
-	{
-		ImGui::SetColumnWidth(2, initialSpacingColumn2);
-		initialSpacingColumn2 = 0.0f;
-	}
+		// Selection user data is the row; the requests are turned into entry indices right away.
+		bool multiSelect = dialogInfo->type == ImGuiFileDialogType_OpenFile && dialogInfo->multiSelect;
+		ImGuiMultiSelectIO* multiSelectIO = nullptr;
+		if (multiSelect)
+		{
+			multiSelectIO = ImGui::BeginMultiSelect(ImGuiMultiSelectFlags_ClearOnEscape | ImGuiMultiSelectFlags_ClearOnClickVoid | ImGuiMultiSelectFlags_BoxSelect1d, (int)dialogInfo->selectedCount, (int)rowCount);
+			ApplySelectionRequests(dialogInfo, multiSelectIO, files->size(), directoryRowsEnd);
+		}
 
-	// File Columns
-	if (ImGui::Selectable("Name"))
-	{
-		sizeSortOrder = ImGuiFileDialogSortOrder_None;
-		dateSortOrder = ImGuiFileDialogSortOrder_None;
-		typeSortOrder = ImGuiFileDialogSortOrder_None;
-		fileNameSortOrder = fileNameSortOrder == ImGuiFileDialogSortOrder_Down ? ImGuiFileDialogSortOrder_Up : ImGuiFileDialogSortOrder_Down;
-	}
-	ImGui::NextColumn();
-	if (ImGui::Selectable("Size"))
-	{
-		fileNameSortOrder = ImGuiFileDialogSortOrder_None;
-		dateSortOrder = ImGuiFileDialogSortOrder_None;
-		typeSortOrder = ImGuiFileDialogSortOrder_None;
-		sizeSortOrder = sizeSortOrder == ImGuiFileDialogSortOrder_Down ? ImGuiFileDialogSortOrder_Up : ImGuiFileDialogSortOrder_Down;
-	}
-	ImGui::NextColumn();
-	if (ImGui::Selectable("Type"))
-	{
-		fileNameSortOrder = ImGuiFileDialogSortOrder_None;
-		dateSortOrder = ImGuiFileDialogSortOrder_None;
-		sizeSortOrder = ImGuiFileDialogSortOrder_None;
-		typeSortOrder = typeSortOrder == ImGuiFileDialogSortOrder_Down ? ImGuiFileDialogSortOrder_Up : ImGuiFileDialogSortOrder_Down;
-	}
-	ImGui::NextColumn();
-	if (ImGui::Selectable("Date"))
-	{
-		fileNameSortOrder = ImGuiFileDialogSortOrder_None;
-		sizeSortOrder = ImGuiFileDialogSortOrder_None;
-		typeSortOrder = ImGuiFileDialogSortOrder_None;
-		dateSortOrder = dateSortOrder == ImGuiFileDialogSortOrder_Down ? ImGuiFileDialogSortOrder_Up : ImGuiFileDialogSortOrder_Down;
-	}
-	ImGui::NextColumn();
+		ImGuiListClipper clipper;
+		clipper.Begin((int)rowCount);
 
-	// File Separator
-	ImGui::Separator();
+		if (dialogInfo->currentIndex < rowCount)
+			clipper.IncludeItemByIndex((int)dialogInfo->currentIndex);
+		if (multiSelectIO && multiSelectIO->RangeSrcItem >= 0 && multiSelectIO->RangeSrcItem < (ImGuiSelectionUserData)rowCount)
+			clipper.IncludeItemByIndex((int)multiSelectIO->RangeSrcItem);
 
-	// Sort directories
-	auto* directories = &dialogInfo->currentDirectories;
+		while (clipper.Step())
+		{
+			dialogInfo->stats.drawnRows += clipper.DisplayEnd - clipper.DisplayStart;
 
-	if (fileNameSortOrder != ImGuiFileDialogSortOrder_None || sizeSortOrder != ImGuiFileDialogSortOrder_None || typeSortOrder != ImGuiFileDialogSortOrder_None)
-	{
-		std::sort(directories->begin(), directories->end(), [](const std::filesystem::directory_entry& a, const std::filesystem::directory_entry& b)
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
 			{
-				if (fileNameSortOrder == ImGuiFileDialogSortOrder_Down)
-				{
-					return a.path().filename() > b.path().filename();
-				}
+				size_t index = (size_t)row;
 
-				return a.path().filename() < b.path().filename();
-			});
-	}
-	else if (dateSortOrder != ImGuiFileDialogSortOrder_None)
-	{
-		std::sort(directories->begin(), directories->end(), [](const std::filesystem::directory_entry& a, const std::filesystem::directory_entry& b)
-			{
-				if (dateSortOrder == ImGuiFileDialogSortOrder_Down)
-				{
-					return a.last_write_time() > b.last_write_time();
-				}
-				return a.last_write_time() < b.last_write_time();
-			});
-	}
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::PushID(row);
 
-	// Sort files
-	auto* files = &dialogInfo->currentFiles;
+				// Every item of the multi-select scope needs user data; requests for rows other
+				// than files are ignored.
+				if (multiSelect && index < directoryRowsEnd)
+					ImGui::SetNextItemSelectionUserData(row);
 
-	if (fileNameSortOrder != ImGuiFileDialogSortOrder_None)
-	{
-		std::sort(files->begin(), files->end(), [](const std::filesystem::directory_entry& a, const std::filesystem::directory_entry& b)
-			{
-				if (fileNameSortOrder == ImGuiFileDialogSortOrder_Down)
+				// Draw parent
+				if (index < parentRows)
 				{
-					return a.path().filename() > b.path().filename();
-				}
+					if (ImGui::Selectable("..", dialogInfo->currentIndex == index, ImGuiSelectableFlags_AllowDoubleClick | ImGuiSelectableFlags_SpanAllColumns))
+					{
+						dialogInfo->currentIndex = index;
 
-				return a.path().filename() < b.path().filename();
-			});
-	}
-	else if (sizeSortOrder != ImGuiFileDialogSortOrder_None)
-	{
-		std::sort(files->begin(), files->end(), [](const std::filesystem::directory_entry& a, const std::filesystem::directory_entry& b)
-			{
-				if (sizeSortOrder == ImGuiFileDialogSortOrder_Down)
-				{
-					return a.file_size() > b.file_size();
+						if (ImGui::IsMouseDoubleClicked(0))
+						{
+							Navigate(dialogInfo, dialogInfo->directoryPath.parent_path());
+						}
+					}
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted("-");
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted("<parent>");
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted("-");
+					for (size_t column = 0; column < dialogInfo->columns.size(); ++column)
+					{
+						if (ImGui::TableNextColumn())
+							ImGui::TextUnformatted("-");
+					}
 				}
-				return a.file_size() < b.file_size();
-			});
-	}
-	else if (typeSortOrder != ImGuiFileDialogSortOrder_None)
-	{
-		std::sort(files->begin(), files->end(), [](const std::filesystem::directory_entry& a, const std::filesystem::directory_entry& b)
-			{
-				if (typeSortOrder == ImGuiFileDialogSortOrder_Down)
+				// Draw directories
+				else if (index < directoryRowsEnd)
 				{
-					return a.path().extension() > b.path().extension();
-				}
+					size_t entryIndex = dialogInfo->displayDirectories[index - parentRows];
 
-				return a.path().extension() < b.path().extension();
-			});
-	}
-	else if (dateSortOrder != ImGuiFileDialogSortOrder_None)
-	{
-		std::sort(files->begin(), files->end(), [](const std::filesystem::directory_entry& a, const std::filesystem::directory_entry& b)
-			{
-				if (dateSortOrder == ImGuiFileDialogSortOrder_Down)
-				{
-					return a.last_write_time() > b.last_write_time();
-				}
-				return a.last_write_time() < b.last_write_time();
-			});
-	}
+					bool clicked = ImGui::Selectable(directories->nameCStr(entryIndex), dialogInfo->currentIndex == index, ImGuiSelectableFlags_AllowDoubleClick | ImGuiSelectableFlags_SpanAllColumns);
+					if (dialogInfo->speculativeScan && ImGui::IsItemHovered())
+						hoveredDirectory = directories->path(dialogInfo->directoryPath, entryIndex);
 
-	size_t index = 0;
+					if (clicked)
+					{
+						dialogInfo->currentIndex = index;
+						if (dialogInfo->type == ImGuiFileDialogType_SelectFolder) dialogInfo->fileName = std::string(directories->name(entryIndex));
 
-	// Draw parent
-	if (dialogInfo->directoryPath.has_parent_path())
-	{
-		if (ImGui::Selectable("..", dialogInfo->currentIndex == index, ImGuiSelectableFlags_AllowDoubleClick, ImVec2(ImGui::GetContentRegionAvail().x, 0)))
-		{
-			dialogInfo->currentIndex = index;
+						if (ImGui::IsMouseDoubleClicked(0))
+						{
+							std::filesystem::path directoryPath = directories->path(dialogInfo->directoryPath, entryIndex);
 
-			if (ImGui::IsMouseDoubleClicked(0))
-			{
-				dialogInfo->directoryPath = dialogInfo->directoryPath.parent_path();
-				dialogInfo->refreshInfo = true;
-			}
-		}
-		ImGui::NextColumn();
-		ImGui::TextUnformatted("-");
-		ImGui::NextColumn();
-		ImGui::TextUnformatted("<parent>");
-		ImGui::NextColumn();
-		ImGui::TextUnformatted("-");
-		ImGui::NextColumn();
+							if (dialogInfo->walk)
+								dialogInfo->searchQuery.clear();
 
-		index++;
-	}
+							Navigate(dialogInfo, directoryPath);
+						}
+					}
 
-	// Draw directories
-	for (size_t i = 0; i < directories->size(); ++i)
-	{
-		auto directoryEntry = dialogInfo->currentDirectories[i];
-		auto directoryPath = directoryEntry.path();
-		auto directoryName = directoryPath.filename();
+					bool hasMetadata = directories->hasMetadata(entryIndex);
+					if (!hasMetadata && !dialogInfo->walk)
+						metadataRequests.push_back({ true, (uint32_t)entryIndex, std::string(directories->name(entryIndex)) });
 
-		if (ImGui::Selectable(directoryName.string().c_str(), dialogInfo->currentIndex == index, ImGuiSelectableFlags_AllowDoubleClick, ImVec2(ImGui::GetContentRegionAvail().x, 0)))
-		{
-			dialogInfo->currentIndex = index;
-			if (dialogInfo->type == ImGuiFileDialogType_SelectFolder) dialogInfo->fileName = directoryName;
+					ImGui::TableNextColumn();
+					if (dialogInfo->folderSizes && directories->fileSize(entryIndex) != ImFileDialogEntryList::unknownSize)
+						ImGui::TextUnformatted(FormatSize(directories->fileSize(entryIndex)).c_str());
+					else
+						ImGui::TextUnformatted(dialogInfo->folderSizes && !dialogInfo->folderSizes->cancelled ? "..." : "-");
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted("<directory>");
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(hasMetadata ? FormatDate(directories->lastWriteTime(entryIndex)).c_str() : "...");
+					DrawColumnValues(dialogInfo, *directories, entryIndex, true, columnRequests);
+				}
+				// Draw files
+				else
+				{
+					size_t entryIndex = dialogInfo->displayFiles[index - directoryRowsEnd];
+					bool selected = dialogInfo->currentIndex == index;
 
-			if (ImGui::IsMouseDoubleClicked(0))
-			{
-				dialogInfo->directoryPath = directoryPath;
-				dialogInfo->refreshInfo = true;
+					if (multiSelect)
+					{
+						ImGui::SetNextItemSelectionUserData(row);
+						selected = dialogInfo->selection.contains(entryIndex);
+					}
+
+					if (ImGui::Selectable(files->nameCStr(entryIndex), selected, ImGuiSelectableFlags_AllowDoubleClick | ImGuiSelectableFlags_SpanAllColumns))
+					{
+						dialogInfo->currentIndex = index;
+						dialogInfo->fileName = std::string(files->name(entryIndex));
+					}
+
+					std::string_view extension = files->extension(entryIndex);
+					bool hasMetadata = files->hasMetadata(entryIndex);
+					if (!hasMetadata && !dialogInfo->walk)
+						metadataRequests.push_back({ false, (uint32_t)entryIndex, std::string(files->name(entryIndex)) });
+
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(hasMetadata ? FormatSize(files->fileSize(entryIndex)).c_str() : "...");
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(extension.data(), extension.data() + extension.size());
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(hasMetadata ? FormatDate(files->lastWriteTime(entryIndex)).c_str() : "...");
+					DrawColumnValues(dialogInfo, *files, entryIndex, false, columnRequests);
+				}
+
+				ImGui::PopID();
 			}
 		}
 
-		ImGui::NextColumn();
-		ImGui::TextUnformatted("-");
-		ImGui::NextColumn();
-		ImGui::TextUnformatted("<directory>");
-		ImGui::NextColumn();
+		if (multiSelect)
+			ApplySelectionRequests(dialogInfo, ImGui::EndMultiSelect(), files->size(), directoryRowsEnd);
 
-		auto lastWriteTime = directoryEntry.last_write_time();
-		auto st = std::chrono::time_point_cast<std::chrono::system_clock::duration>(lastWriteTime - decltype(lastWriteTime)::clock::now() + std::chrono::system_clock::now());
-		std::time_t tt = std::chrono::system_clock::to_time_t(st);
-		std::tm mt;
-#ifdef _WIN32
-		localtime_s(&mt, &tt);
-#elif __linux__
-		localtime_r(&tt, &mt);
-#endif
-		std::stringstream ss;
-		ss << std::put_time(&mt, "%F %R");
-		ImGui::TextUnformatted(ss.str().c_str());
-		ImGui::NextColumn();
+		if (!dialogInfo->walk)
+			RequestVisibleMetadata(dialogInfo, metadataRequests);
 
-		index++;
-	}
+		RequestVisibleColumnValues(dialogInfo, columnRequests);
 
-	// Draw files
-	for (size_t i = 0; i < files->size(); ++i)
-	{
-		auto fileEntry = dialogInfo->currentFiles[i];
-		auto filePath = fileEntry.path();
-		auto fileName = filePath.filename();
+		// Nothing is speculated on the frame a folder is opened; the rows still show the old one.
+		if ((dialogInfo->speculativeScan || dialogInfo->speculation) && dialogInfo->scannedPath == dialogInfo->directoryPath)
+		{
+			std::filesystem::path selectedDirectory;
+			if (dialogInfo->currentIndex >= parentRows && dialogInfo->currentIndex < directoryRowsEnd)
+				selectedDirectory = directories->path(dialogInfo->directoryPath, dialogInfo->displayDirectories[dialogInfo->currentIndex - parentRows]);
 
-		if (ImGui::Selectable(fileName.string().c_str(), dialogInfo->currentIndex == index, ImGuiSelectableFlags_AllowDoubleClick, ImVec2(ImGui::GetContentRegionAvail().x, 0)))
+			UpdateSpeculation(dialogInfo, hoveredDirectory, selectedDirectory);
+		}
+
+		if (dialogInfo->currentIndex >= directoryRowsEnd && dialogInfo->currentIndex < rowCount)
 		{
-			dialogInfo->currentIndex = index;
-			dialogInfo->fileName = fileName;
+			size_t entryIndex = dialogInfo->displayFiles[dialogInfo->currentIndex - directoryRowsEnd];
+			previewPath = files->path(dialogInfo->directoryPath, entryIndex);
+			previewWriteTime = files->lastWriteTime(entryIndex);
 		}
 
-		ImGui::NextColumn();
-		ImGui::TextUnformatted(std::to_string(fileEntry.file_size()).c_str());
-		ImGui::NextColumn();
-		ImGui::TextUnformatted(filePath.extension().string().c_str());
-		ImGui::NextColumn();
+		ImGui::EndTable();
+	}
 
-		auto lastWriteTime = fileEntry.last_write_time();
-		auto st = std::chrono::time_point_cast<std::chrono::system_clock::duration>(lastWriteTime - decltype(lastWriteTime)::clock::now() + std::chrono::system_clock::now());
-		std::time_t tt = std::chrono::system_clock::to_time_t(st);
-		std::tm mt;
-#ifdef _WIN32
-		localtime_s(&mt, &tt);
-#elif __linux__
-		localtime_r(&tt, &mt);
-#endif
-		std::stringstream ss;
-		ss << std::put_time(&mt, "%F %R");
-		ImGui::TextUnformatted(ss.str().c_str());
-		ImGui::NextColumn();
+	// Draw preview
+	if (dialogInfo->showPreview)
+	{
+		UpdatePreview(dialogInfo, previewPath, previewWriteTime);
 
-		index++;
+		ImGui::SameLine();
+		if (ImGui::BeginChild("##preview", ImVec2(0, 300), ImGuiChildFlags_Borders, ImGuiWindowFlags_HorizontalScrollbar))
+			DrawPreview(dialogInfo, textErrorColor);
+		ImGui::EndChild();
+	}
+	else if (dialogInfo->preview)
+	{
+		CancelPreview(dialogInfo);
 	}
-	ImGui::EndChild();
 
 	// Draw filename
 	static const size_t fileNameBufferSize = 200;
-	static char fileNameBuffer[fileNameBufferSize];
+	char fileNameBuffer[fileNameBufferSize];
 
 	std::string fileNameStr = dialogInfo->fileName.string();
 	size_t fileNameSize = fileNameStr.size();
@@ -425,53 +5998,55 @@ bool ImGui::FileDialog(bool* open, ImFileDialogInfo* dialogInfo)
 	}
 
 	if (ImGui::Button("Cancel"))
-	{
-		fileNameSortOrder = ImGuiFileDialogSortOrder_None;
-		sizeSortOrder = ImGuiFileDialogSortOrder_None;
-		typeSortOrder = ImGuiFileDialogSortOrder_None;
-		dateSortOrder = ImGuiFileDialogSortOrder_None;
-
-		dialogInfo->refreshInfo = false;
-		dialogInfo->currentIndex = 0;
-		dialogInfo->currentFiles.clear();
-		dialogInfo->currentDirectories.clear();
-
-		*open = false;
-	}
+		CloseDialog(dialogInfo, open);
 
 	ImGui::SameLine();
 
+	// A typed name is checked on a worker, so a stalled mount never blocks the frame; the button
+	// ignores presses while the check is out.
 	if (dialogInfo->type == ImGuiFileDialogType_OpenFile)
 	{
-		if (ImGui::Button("Open"))
+		if (ImGui::Button("Open") && !dialogInfo->confirmCheck)
 		{
-			dialogInfo->resultPath = dialogInfo->directoryPath / dialogInfo->fileName;
+			// Selected files come from the listing; a typed name is checked on disk.
+			dialogInfo->resultPaths.clear();
+			if (dialogInfo->multiSelect && dialogInfo->selectedCount != 0)
+				dialogInfo->resultPaths = SelectedPaths(dialogInfo);
 
-			if (std::filesystem::exists(dialogInfo->resultPath))
-			{
-				if (std::filesystem::is_regular_file(dialogInfo->resultPath)) {
-					fileNameSortOrder = ImGuiFileDialogSortOrder_None;
-					sizeSortOrder = ImGuiFileDialogSortOrder_None;
-					typeSortOrder = ImGuiFileDialogSortOrder_None;
-					dateSortOrder = ImGuiFileDialogSortOrder_None;
+			bool selectedFiles = !dialogInfo->resultPaths.empty();
+			if (!selectedFiles)
+				dialogInfo->resultPaths.push_back(dialogInfo->directoryPath / dialogInfo->fileName);
 
-					fileChooseError = false;
+			dialogInfo->resultPath = dialogInfo->resultPaths.front();
 
-					dialogInfo->refreshInfo = false;
-					dialogInfo->currentIndex = 0;
-					dialogInfo->currentFiles.clear();
-					dialogInfo->currentDirectories.clear();
+			if (selectedFiles) {
+				dialogInfo->fileChooseError = false;
+				CloseDialog(dialogInfo, open);
+				complete = true;
+			}
+			else {
+				dialogInfo->confirmCheck = StartPathCheck(dialogInfo, dialogInfo->resultPath);
+			}
+		}
 
-					complete = true;
-					*open = false;
-				}
-				else {
-					fileChooseError = true;
-				}
+		if (std::shared_ptr<ImFileDialogPathCheck> check = TakeConfirmCheck(dialogInfo))
+		{
+			if (check->isRegularFile) {
+				dialogInfo->fileChooseError = false;
+				CloseDialog(dialogInfo, open);
+				complete = true;
+			}
+			else if (check->exists) {
+				dialogInfo->fileChooseError = true;
 			}
 		}
 
-		if (fileChooseError) {
+		if (dialogInfo->multiSelect && dialogInfo->selectedCount > 1) {
+			ImGui::SameLine();
+			ImGui::TextDisabled("%zu selected", dialogInfo->selectedCount);
+		}
+
+		if (dialogInfo->fileChooseError) {
 			ImGui::SameLine();
 			ImGui::TextColored(textErrorColor, "The selected item is not a regular file");
 		}
@@ -479,27 +6054,21 @@ bool ImGui::FileDialog(bool* open, ImFileDialogInfo* dialogInfo)
 	}
 	else if (dialogInfo->type == ImGuiFileDialogType_SaveFile)
 	{
-		if (ImGui::Button("Save"))
+		if (ImGui::Button("Save") && !dialogInfo->confirmCheck)
 		{
 			dialogInfo->resultPath = dialogInfo->directoryPath / dialogInfo->fileName;
+			dialogInfo->confirmCheck = StartPathCheck(dialogInfo, dialogInfo->resultPath);
+		}
 
-			if (std::filesystem::exists(dialogInfo->resultPath))
+		if (std::shared_ptr<ImFileDialogPathCheck> check = TakeConfirmCheck(dialogInfo))
+		{
+			if (check->exists)
 			{
 				ImGui::OpenPopup("File Exists");
 			}
 			else {
-				fileNameSortOrder = ImGuiFileDialogSortOrder_None;
-				sizeSortOrder = ImGuiFileDialogSortOrder_None;
-				typeSortOrder = ImGuiFileDialogSortOrder_None;
-				dateSortOrder = ImGuiFileDialogSortOrder_None;
-
-				dialogInfo->refreshInfo = false;
-				dialogInfo->currentIndex = 0;
-				dialogInfo->currentFiles.clear();
-				dialogInfo->currentDirectories.clear();
-
+				CloseDialog(dialogInfo, open);
 				complete = true;
-				*open = false;
 			}
 		}
 
@@ -526,18 +6095,8 @@ bool ImGui::FileDialog(bool* open, ImFileDialogInfo* dialogInfo)
 
 			if (ImGui::Button("Yes"))
 			{
-				fileNameSortOrder = ImGuiFileDialogSortOrder_None;
-				sizeSortOrder = ImGuiFileDialogSortOrder_None;
-				typeSortOrder = ImGuiFileDialogSortOrder_None;
-				dateSortOrder = ImGuiFileDialogSortOrder_None;
-
-				dialogInfo->refreshInfo = false;
-				dialogInfo->currentIndex = 0;
-				dialogInfo->currentFiles.clear();
-				dialogInfo->currentDirectories.clear();
-
+				CloseDialog(dialogInfo, open);
 				complete = true;
-				*open = false;
 				ImGui::CloseCurrentPopup();
 			}
 
@@ -553,35 +6112,25 @@ bool ImGui::FileDialog(bool* open, ImFileDialogInfo* dialogInfo)
 	}
 	else if (dialogInfo->type == ImGuiFileDialogType_SelectFolder)
 	{
-		if (ImGui::Button("Select"))
+		if (ImGui::Button("Select") && !dialogInfo->confirmCheck)
 		{
 			dialogInfo->resultPath = dialogInfo->directoryPath / dialogInfo->fileName;
+			dialogInfo->confirmCheck = StartPathCheck(dialogInfo, dialogInfo->resultPath);
+		}
 
-			if (std::filesystem::exists(dialogInfo->resultPath))
-			{
-				if (std::filesystem::is_directory(dialogInfo->resultPath)) {
-					fileNameSortOrder = ImGuiFileDialogSortOrder_None;
-					sizeSortOrder = ImGuiFileDialogSortOrder_None;
-					typeSortOrder = ImGuiFileDialogSortOrder_None;
-					dateSortOrder = ImGuiFileDialogSortOrder_None;
-
-					folderSelectError = false;
-
-					dialogInfo->refreshInfo = false;
-					dialogInfo->currentIndex = 0;
-					dialogInfo->currentFiles.clear();
-					dialogInfo->currentDirectories.clear();
-
-					complete = true;
-					*open = false;
-				}
-				else {
-					folderSelectError = true;
-				}
+		if (std::shared_ptr<ImFileDialogPathCheck> check = TakeConfirmCheck(dialogInfo))
+		{
+			if (check->isDirectory) {
+				dialogInfo->folderSelectError = false;
+				CloseDialog(dialogInfo, open);
+				complete = true;
+			}
+			else if (check->exists) {
+				dialogInfo->folderSelectError = true;
 			}
 		}
 
-		if (folderSelectError) {
+		if (dialogInfo->folderSelectError) {
 			ImGui::SameLine();
 			ImGui::TextColored(textErrorColor, "The selected item is not a folder");
 		}
@@ -597,20 +6146,34 @@ bool ImGui::FileDialog(bool* open, ImFileDialogInfo* dialogInfo)
 
 		const char* currentFilterName = dialogInfo->parsedFilters.keyAt(dialogInfo->currentFilterIndex).c_str();
 		if (ImGui::BeginCombo("##Filters", currentFilterName)) {
-			for (int i = 0; i < dialogInfo->parsedFilters.size(); ++i) {
+			for (size_t i = 0; i < dialogInfo->parsedFilters.size(); ++i) {
 				bool isSelected = (dialogInfo->currentFilterIndex == i);
 
 				if (ImGui::Selectable(dialogInfo->parsedFilters.keyAt(i).c_str(), isSelected)) {
 					dialogInfo->currentFilterIndex = i;
-					dialogInfo->refreshInfo = true;
+					dialogInfo->currentIndex = 0;
+					dialogInfo->refreshDisplay = true;
 				}
 			}
 			ImGui::EndCombo();
 		}
 	}
 
+	if (complete)
+	{
+		LoadPlaces(dialogInfo);
+		AddPlace(dialogInfo->recentDirectories, dialogInfo->directoryPath, dialogInfo->recentMaxEntries);
+		SavePlaces(dialogInfo);
+	}
+
+	if (dialogInfo->showStats)
+		DrawStats(dialogInfo);
+
 	ImGui::End();
 	ImGui::PopID();
 
+	AddCounters(dialogInfo->stats.total, dialogInfo->stats.frame);
+	dialogInfo->stats.frames++;
+
 	return complete;
 }
\ No newline at end of file
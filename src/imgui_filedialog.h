@@ -10,9 +10,13 @@
 
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <imgui.h>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -26,6 +30,39 @@ enum ImGuiFileDialogType_
 	ImGuiFileDialogType_SelectFolder
 };
 
+typedef int ImGuiFileDialogSortOrder;	// -> enum ImGuiFileDialogSortOrder_   // Enum: A sort direction of a column
+
+enum ImGuiFileDialogSortOrder_
+{
+	ImGuiFileDialogSortOrder_Up,
+	ImGuiFileDialogSortOrder_Down,
+	ImGuiFileDialogSortOrder_None
+};
+
+typedef int ImGuiFileDialogColumnCost;	// -> enum ImGuiFileDialogColumnCost_  // Enum: How a column's values are computed
+
+enum ImGuiFileDialogColumnCost_
+{
+	ImGuiFileDialogColumnCost_Cheap,
+	ImGuiFileDialogColumnCost_Expensive
+};
+
+struct ImFileDialogScan;
+struct ImFileDialogWatch;
+struct ImFileDialogCache;
+struct ImFileDialogSearch;
+struct ImFileDialogWalk;
+struct ImFileDialogMetadata;
+struct ImFileDialogService;
+struct ImFileDialogPreview;
+struct ImFileDialogFolderSizes;
+struct ImFileDialogSpeculation;
+struct ImFileDialogPathBar;
+struct ImFileDialogColumnValues;
+struct ImFileDialogTree;
+struct ImFileDialogPathCheck;
+struct ImFileDialogPlacesLoad;
+
 template <typename Key, typename Value>
 class ordered_map {
 private:
@@ -61,6 +98,14 @@ public:
 		return map.at(key);
 	}
 
+	const Value& at(size_t index) const {
+		if (index >= keys.size()) {
+			throw std::out_of_range("Index out of range");
+		}
+		const Key& key = keys[index];
+		return map.at(key);
+	}
+
 	const Key& keyAt(size_t index) const {
 		if (index >= keys.size()) {
 			throw std::out_of_range("Index out of range");
@@ -85,26 +130,380 @@ public:
 	}
 };
 
+// A compiled file filter. Plain extensions (".png", "*.png") go into a case-insensitive hash
+// table, anything else (such as ".tar.gz", "*.tar.gz" or "frame_????.exr") is matched as a
+// glob against the whole file name. Matching never allocates.
+class ImFileDialogFilter
+{
+private:
+	bool matchAll = false;
+	size_t extensionCount = 0;
+	std::vector<std::string> extensionTable;
+	std::vector<std::string> globs;
+	std::vector<std::string> patterns;
+
+	void insertExtension(std::string extension);
+
+public:
+	void add(const std::string& pattern);
+	bool matches(std::string_view fileName) const;
+
+	const std::vector<std::string>& source() const {
+		return patterns;
+	}
+
+	bool empty() const {
+		return patterns.empty();
+	}
+};
+
+// One listing of files or directories, stored column by column. Names are packed back to back
+// into a single arena, each terminated by '\0'; full paths are rebuilt from the listed
+// directory only when needed. Sizes and times that could not be read are unknownSize and
+// unknownTime. Entries listed without metadata hold neither until setMetadata is called.
+// Every name also gets a collation key when it is added: lowercase, with each run of digits
+// encoded so that plain byte comparison of two keys orders the numbers by value.
+class ImFileDialogEntryList
+{
+private:
+	std::string nameArena;
+	std::vector<uint32_t> nameOffsets;
+	std::string keyArena;
+	std::vector<uint32_t> keyOffsets;
+	std::vector<uint16_t> extensionOffsets;
+	std::vector<std::uintmax_t> sizes;
+	std::vector<std::filesystem::file_time_type> lastWriteTimes;
+	std::vector<uint64_t> filterMasks;
+	std::vector<uint8_t> metadataFlags;
+	size_t missingMetadata = 0;
+
+public:
+	static constexpr std::uintmax_t unknownSize = ~std::uintmax_t(0);
+	static constexpr std::filesystem::file_time_type unknownTime = std::filesystem::file_time_type::min();
+
+	void push_back(std::string_view name, std::uintmax_t size, std::filesystem::file_time_type lastWriteTime, uint64_t filterMask);
+	void push_back(std::string_view name, uint64_t filterMask);
+	void append(const ImFileDialogEntryList& other, size_t first = 0);
+	void compact(const std::vector<uint32_t>& remap);
+	void clear();
+	size_t bytes() const;
+
+	size_t size() const {
+		return sizes.size();
+	}
+
+	bool empty() const {
+		return sizes.empty();
+	}
+
+	// The name is a path relative to the listed directory; for a plain listing that is the file name.
+	std::string_view name(size_t index) const {
+		size_t end = index + 1 < nameOffsets.size() ? nameOffsets[index + 1] : nameArena.size();
+		return std::string_view(nameArena.data() + nameOffsets[index], end - nameOffsets[index] - 1);
+	}
+
+	const char* nameCStr(size_t index) const {
+		return nameArena.data() + nameOffsets[index];
+	}
+
+	std::string_view fileName(size_t index) const;
+
+	std::string_view collationKey(size_t index) const {
+		size_t end = index + 1 < keyOffsets.size() ? keyOffsets[index + 1] : keyArena.size();
+		return std::string_view(keyArena.data() + keyOffsets[index], end - keyOffsets[index]);
+	}
+
+	std::string_view extension(size_t index) const {
+		return name(index).substr(extensionOffsets[index]);
+	}
+
+	std::uintmax_t fileSize(size_t index) const {
+		return sizes[index];
+	}
+
+	std::filesystem::file_time_type lastWriteTime(size_t index) const {
+		return lastWriteTimes[index];
+	}
+
+	uint64_t filterMask(size_t index) const {
+		return filterMasks[index];
+	}
+
+	void setFilterMask(size_t index, uint64_t filterMask) {
+		filterMasks[index] = filterMask;
+	}
+
+	bool hasMetadata(size_t index) const {
+		return metadataFlags[index] != 0;
+	}
+
+	size_t missingMetadataCount() const {
+		return missingMetadata;
+	}
+
+	void setFileSize(size_t index, std::uintmax_t size) {
+		sizes[index] = size;
+	}
+
+	void setMetadata(size_t index, std::uintmax_t size, std::filesystem::file_time_type lastWriteTime) {
+		missingMetadata -= metadataFlags[index] ? 0 : 1;
+		metadataFlags[index] = 1;
+		sizes[index] = size;
+		lastWriteTimes[index] = lastWriteTime;
+	}
+
+	std::filesystem::path path(const std::filesystem::path& directoryPath, size_t index) const {
+		return directoryPath / name(index);
+	}
+};
+
+// One entry reported by a custom listing function. A size or time that could not be read is
+// left unknown, with the reason in `error`.
+struct ImFileDialogDirectoryEntry
+{
+	std::string_view name;
+	bool isDirectory = false;
+	std::uintmax_t size = ImFileDialogEntryList::unknownSize;
+	std::filesystem::file_time_type lastWriteTime = ImFileDialogEntryList::unknownTime;
+	std::error_code error;
+};
+
+// Lists a directory in place of the file system, for virtual file systems and tests. Calls
+// `visit` for each entry until it returns false and reports a failed listing in `error`.
+// Runs on a worker thread.
+typedef std::function<void(const std::filesystem::path& directoryPath, const std::function<bool(const ImFileDialogDirectoryEntry&)>& visit, std::error_code& error)> ImFileDialogListFunction;
+
+// What a column provider gets for one entry. Size and time are unknown while lazyMetadata has
+// not read them yet.
+struct ImFileDialogColumnEntry
+{
+	std::filesystem::path path;
+	bool isDirectory = false;
+	std::uintmax_t size = ImFileDialogEntryList::unknownSize;
+	std::filesystem::file_time_type lastWriteTime = ImFileDialogEntryList::unknownTime;
+};
+
+// An extra column of the file table, such as permissions, an owner or a content hash. Cheap
+// values are computed as their rows are drawn. Expensive ones are computed on worker threads for
+// the rows on screen, and cached by path and modification time. The cache is shared by the
+// dialogs of a service under `cacheKey`, which columns may only share when their providers
+// compute the same values; left empty, the values are cached for this dialog's column alone.
+// Sorting by a column compares its values as text and computes every expensive one first.
+struct ImFileDialogColumn
+{
+	std::string name;
+	float width = 90.0f;
+	ImGuiFileDialogColumnCost cost = ImGuiFileDialogColumnCost_Cheap;
+	std::function<std::string(const ImFileDialogColumnEntry& entry)> value;
+	ImGuiFileDialogSortOrder sortOrder = ImGuiFileDialogSortOrder_None;
+	std::string cacheKey;
+};
+
+// A set of entry indices of one listing. A bit marks an entry that differs from the default
+// state, so selecting or clearing the whole listing is O(1) however long it is. Selecting
+// everything covers the entries listed at that moment; entries added later start unselected.
+// The number of selected entries is kept as they change.
+class ImFileDialogSelection
+{
+private:
+	std::vector<uint64_t> toggled;
+	bool allSelected = false;
+	size_t allSelectedEnd = 0;
+	size_t selectedCount = 0;
+
+	bool selectedByDefault(size_t index) const {
+		return allSelected && index < allSelectedEnd;
+	}
+
+public:
+	void set(size_t index, bool selected);
+	void remap(const std::vector<uint32_t>& remap);
+
+	bool empty() const {
+		return selectedCount == 0;
+	}
+
+	// Selects the entries below `count` and clears the rest.
+	void selectAll(size_t count) {
+		toggled.clear();
+		allSelected = true;
+		allSelectedEnd = count;
+		selectedCount = count;
+	}
+
+	void clear() {
+		toggled.clear();
+		allSelected = false;
+		allSelectedEnd = 0;
+		selectedCount = 0;
+	}
+
+	bool contains(size_t index) const {
+		size_t word = index / 64;
+		bool bit = word < toggled.size() && (toggled[word] >> (index % 64) & 1) != 0;
+		return bit != selectedByDefault(index);
+	}
+};
+
+// Work done by the dialog. Times are milliseconds of the calling thread; filesystem calls
+// count directory opens and metadata queries, including those made by background workers.
+struct ImFileDialogCounters
+{
+	double scanMs = 0.0;
+	double filterMs = 0.0;
+	double sortMs = 0.0;
+	double drawMs = 0.0;
+	uint64_t filesystemCalls = 0;
+	uint64_t scannedEntries = 0;
+};
+
+struct ImFileDialogStats
+{
+	ImFileDialogCounters frame;
+	ImFileDialogCounters total;
+	uint64_t frames = 0;
+
+	// Wall time of the last complete directory scan, including background scans.
+	double lastScanMs = 0.0;
+
+	size_t listedEntries = 0;
+	size_t displayedEntries = 0;
+	size_t drawnRows = 0;
+};
+
 struct ImFileDialogInfo
 {
 	std::string title;
-	ImGuiFileDialogType type;
+	ImGuiFileDialogType type = ImGuiFileDialogType_OpenFile;
 	std::vector<std::string> filters;
 
 	std::filesystem::path fileName;
 	std::filesystem::path directoryPath;
 	std::filesystem::path resultPath;
 
-	bool refreshInfo;
-	size_t currentIndex;
-	size_t currentFilterIndex;
-	ordered_map<std::string, std::vector<std::string>> parsedFilters;
-	std::vector<std::filesystem::directory_entry> currentFiles;
-	std::vector<std::filesystem::directory_entry> currentDirectories;
+	// With multiSelect set, an OpenFile dialog returns every selected file in resultPaths, in the
+	// order shown. The selection holds entry indices, so sorting and filtering leave it intact;
+	// entries hidden by the filter or the search are not returned.
+	bool multiSelect = false;
+	ImFileDialogSelection selection;
+	size_t selectedCount = 0;
+	std::vector<std::filesystem::path> resultPaths;
+
+	bool refreshInfo = false;
+	size_t currentIndex = 0;
+	size_t currentFilterIndex = 0;
+	ordered_map<std::string, ImFileDialogFilter> parsedFilters;
+	ImFileDialogEntryList currentFiles;
+	ImFileDialogEntryList currentDirectories;
+
+	ImGuiFileDialogSortOrder fileNameSortOrder = ImGuiFileDialogSortOrder_None;
+	ImGuiFileDialogSortOrder sizeSortOrder = ImGuiFileDialogSortOrder_None;
+	ImGuiFileDialogSortOrder dateSortOrder = ImGuiFileDialogSortOrder_None;
+	ImGuiFileDialogSortOrder typeSortOrder = ImGuiFileDialogSortOrder_None;
+	bool refreshSort = true;
+	bool refreshDisplay = true;
+	std::vector<uint32_t> sortedFiles;
+	std::vector<uint32_t> sortedDirectories;
+	std::vector<uint32_t> displayFiles;
+	std::vector<uint32_t> displayDirectories;
+
+	std::string searchQuery;
+	bool fuzzySearch = false;
+	std::shared_ptr<ImFileDialogSearch> search;
+
+	// Sorts names case-insensitively with numbers by value, so frame_2 comes before frame_10.
+	bool naturalSort = false;
+
+	bool recursiveSearch = false;
+	int recursiveSearchDepth = 16;
+	size_t recursiveSearchLimit = 10000;
+	std::shared_ptr<ImFileDialogWalk> walk;
+	std::shared_ptr<ImFileDialogMetadata> metadata;
+
+	bool showFolderSizes = false;
+	std::shared_ptr<ImFileDialogFolderSizes> folderSizes;
 
+	// Extra columns after the built-in ones. Without any, nothing is computed or allocated.
+	std::vector<ImFileDialogColumn> columns;
+	std::shared_ptr<ImFileDialogColumnValues> columnValues;
+	uint64_t columnCacheId = 0;
+
+	bool showPreview = false;
+	size_t previewCacheMaxBytes = 8 * 1024 * 1024;
+	std::shared_ptr<ImFileDialogPreview> preview;
+
+	bool asyncScan = false;
+	bool lazyMetadata = false;
+
+	// Listing never throws and never holds the frame for long. Without asyncScan, the dialog
+	// waits up to syncScanTimeoutMs for a listing, then shows the rest as it streams in. A scan
+	// still running after scanDeadlineMs (0 for none) stops, keeping what it has listed.
+	double syncScanTimeoutMs = 200.0;
+	double scanDeadlineMs = 30000.0;
+	ImFileDialogListFunction listDirectory;
+
+	bool watchDirectory = false;
+	std::filesystem::path scannedPath;
+	std::filesystem::file_time_type scannedWriteTime;
+	std::shared_ptr<ImFileDialogScan> scan;
+	std::shared_ptr<ImFileDialogWatch> watch;
+
+	// Folder status reads the dialog waits for on a worker: whether a listing served from the
+	// cache is still current, and whether a folder typed or picked from the places exists.
+	std::shared_ptr<ImFileDialogPathCheck> listingCheck;
+	std::shared_ptr<ImFileDialogPathCheck> navigationCheck;
+
+	// Whether the name typed for Open, Save or Select exists, read on a worker when the button is
+	// pressed. The dialog completes once it is back.
+	std::shared_ptr<ImFileDialogPathCheck> confirmCheck;
+
+	// Starts listing a folder in the background while it is hovered or selected, so opening it
+	// takes the listing already read.
+	bool speculativeScan = false;
+	std::shared_ptr<ImFileDialogSpeculation> speculation;
+
+	// Scans, listings and worker threads, shared with every dialog using the same service.
+	// Left empty, the dialog joins the process-wide service.
+	std::shared_ptr<ImFileDialogService> service;
+	size_t cacheMaxListings = 16;
+	size_t cacheMaxBytes = 64 * 1024 * 1024;
+
+	std::vector<std::filesystem::path> backHistory;
+	std::vector<std::filesystem::path> forwardHistory;
+
+	// The editable path above the listing; Tab completes folder names.
+	std::shared_ptr<ImFileDialogPathBar> pathBar;
+
+	// Folders the dialog completed in, most recent first, and bookmarked folders. Both are read
+	// from and written to placesFile on the worker pool when it is set. Once the file is read, the
+	// first prefetchRecent recent folders are listed in the background into the shared cache.
+	bool showPlaces = false;
+	std::filesystem::path placesFile;
+	bool placesLoaded = false;
+	std::shared_ptr<ImFileDialogPlacesLoad> placesLoad;
+	std::vector<std::filesystem::path> recentDirectories;
+	std::vector<std::filesystem::path> bookmarks;
+	size_t recentMaxEntries = 10;
+	size_t prefetchRecent = 4;
+
+	// A folder tree beside the listing. A folder's sub-folders are listed in the background when
+	// it is first expanded, through the same scans and cache as the listing, and again when the
+	// folder changes. The folders above the one on screen are expanded to show it.
+	bool showTree = false;
+	std::shared_ptr<ImFileDialogTree> tree;
+
+	bool folderSelectError = false;
+	bool fileChooseError = false;
+
+	ImFileDialogStats stats;
+	bool showStats = false;
 };
 
 namespace ImGui
 {
 	IMGUI_API bool FileDialog(bool* open, ImFileDialogInfo* dialogInfo);
+
+	// Loads the places file and lists directoryPath and the recent folders in the background,
+	// so the dialog opens from the cache. Call it on application start; opening does the rest.
+	IMGUI_API void FileDialogPrefetch(ImFileDialogInfo* dialogInfo);
 }
\ No newline at end of file
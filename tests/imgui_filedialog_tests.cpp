@@ -0,0 +1,799 @@
+/*
+	Tests for ImGuiFileDialog.
+
+	Runs the internal passes against crafted inputs and reports every failed check on stderr.
+	The process exits with a non-zero status when any check failed.
+
+	Usage: imgui_filedialog_tests
+*/
+
+// Built into the tests directly so the internal passes can be called on their own.
+#include "imgui_filedialog.cpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			failures++; \
+		} \
+	} while (0)
+
+static void WriteLE16(std::vector<uint8_t>& data, size_t offset, uint16_t value)
+{
+	data[offset] = (uint8_t)value;
+	data[offset + 1] = (uint8_t)(value >> 8);
+}
+
+static void WriteLE32(std::vector<uint8_t>& data, size_t offset, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+		data[offset + i] = (uint8_t)(value >> (i * 8));
+}
+
+static void WriteLE64(std::vector<uint8_t>& data, size_t offset, uint64_t value)
+{
+	for (int i = 0; i < 8; ++i)
+		data[offset + i] = (uint8_t)(value >> (i * 8));
+}
+
+// A tar header at `offset` whose size field holds `size` bytes in base-256.
+static void WriteTarHeader(std::vector<uint8_t>& data, size_t offset, uint64_t size)
+{
+	std::memcpy(&data[offset], "member", 6);
+	std::memcpy(&data[offset + 257], "ustar", 5);
+	data[offset + 156] = '0';
+	data[offset + 124] = 0x80;
+	for (int i = 0; i < 8; ++i)
+		data[offset + 124 + 4 + i] = (uint8_t)(size >> ((7 - i) * 8));
+}
+
+static std::vector<std::string> DescribeArchiveDetails(const std::vector<uint8_t>& data)
+{
+	ImFileDialogPreviewData preview;
+	std::atomic<bool> cancelled{ false };
+	CHECK(DescribeArchive(preview, data.data(), data.size(), cancelled));
+	return preview.details;
+}
+
+static void TestZip64OffsetPastEnd()
+{
+	// An end of central directory record pointing its ZIP64 locator at an offset that wraps
+	// around when 56 is added to it.
+	std::vector<uint8_t> data(64, 0);
+	data[0] = 'P';
+	data[1] = 'K';
+	data[2] = 5;
+	data[3] = 6;
+
+	size_t locator = 20;
+	WriteLE32(data, locator, 0x07064b50);
+	WriteLE64(data, locator + 8, UINT64_MAX - 40);
+
+	size_t record = locator + 20;
+	WriteLE32(data, record, 0x06054b50);
+	WriteLE16(data, record + 10, 0xFFFF);
+
+	std::vector<std::string> details = DescribeArchiveDetails(data);
+	CHECK(details.size() == 1 && details[0] == "65535 entries");
+}
+
+static void TestTarMemberSizeOverflow()
+{
+	// The first member claims nearly 2^64 bytes, which wrapped the next header offset back
+	// onto the second member; the walk has to stop at the first one.
+	std::vector<uint8_t> data(512 * 4, 0);
+	WriteTarHeader(data, 0, UINT64_MAX - 100);
+	WriteTarHeader(data, 512, 0);
+
+	std::vector<std::string> details = DescribeArchiveDetails(data);
+	CHECK(details.size() == 1 && details[0] == "1 entries");
+
+	// A member running past the end of the file stops the walk as well.
+	WriteTarHeader(data, 0, 512 * 3);
+	details = DescribeArchiveDetails(data);
+	CHECK(details.size() == 1 && details[0] == "1 entries");
+
+	// Well-formed members are all counted, their data padded to whole blocks.
+	std::fill(data.begin(), data.end(), 0);
+	WriteTarHeader(data, 0, 100);
+	WriteTarHeader(data, 1024, 0);
+	details = DescribeArchiveDetails(data);
+	CHECK(details.size() == 1 && details[0] == "2 entries");
+}
+
+static void TestMapFileSkipsSpecialFiles(const std::filesystem::path& root)
+{
+#ifndef _WIN32
+	// Opening a FIFO without a writer would block the preview worker forever.
+	std::filesystem::path fifo = root / "preview.fifo";
+	std::filesystem::remove(fifo);
+	CHECK(mkfifo(fifo.c_str(), 0600) == 0);
+
+	ImFileDialogMappedFile special;
+	std::error_code specialError;
+	CHECK(!MapFile(special, fifo, specialError));
+	CHECK(specialError == std::errc::not_supported);
+	std::filesystem::remove(fifo);
+#endif
+
+	std::filesystem::path regular = root / "preview.txt";
+	std::ofstream(regular) << "preview";
+
+	ImFileDialogMappedFile file;
+	std::error_code error;
+	CHECK(MapFile(file, regular, error));
+	CHECK(file.size == 7 && std::memcmp(file.data, "preview", 7) == 0);
+}
+
+// A listing backend standing in for a network mount that stops answering: it lists `entries`
+// names, then blocks until released, as a hung readdir would.
+struct StalledMount
+{
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool released = false;
+	size_t entries = 0;
+
+	void release()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			released = true;
+		}
+		condition.notify_all();
+	}
+};
+
+static ImFileDialogListFunction StalledListing(std::shared_ptr<StalledMount> mount)
+{
+	return [mount](const std::filesystem::path&, const std::function<bool(const ImFileDialogDirectoryEntry&)>& visit, std::error_code&)
+		{
+			for (size_t i = 0; i < mount->entries; ++i)
+			{
+				std::string name = "remote_" + std::to_string(i) + ".txt";
+				ImFileDialogDirectoryEntry entry;
+				entry.name = name;
+				if (!visit(entry))
+					return;
+			}
+
+			std::unique_lock<std::mutex> lock(mount->mutex);
+			mount->condition.wait(lock, [&]() { return mount->released; });
+		};
+}
+
+static double ElapsedSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void TestStalledListings(const std::filesystem::path& root)
+{
+	auto service = std::make_shared<ImFileDialogService>();
+	auto mount = std::make_shared<StalledMount>();
+	mount->entries = 8;
+
+	// More hung listings than the pool has threads.
+	std::vector<std::unique_ptr<ImFileDialogInfo>> stalled;
+	for (unsigned i = 0; i < poolMaxThreads + 4; ++i)
+	{
+		auto info = std::make_unique<ImFileDialogInfo>();
+		info->directoryPath = root;
+		info->service = service;
+		info->scanDeadlineMs = 50.0;
+		info->listDirectory = StalledListing(mount);
+		ParseFilters(info.get());
+
+		// Starting and reading a scan never waits for the backend.
+		auto start = std::chrono::steady_clock::now();
+		StartScan(info.get());
+		ConsumeScan(info.get());
+		CHECK(ElapsedSince(start) < 25.0);
+
+		stalled.push_back(std::move(info));
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	for (std::unique_ptr<ImFileDialogInfo>& info : stalled)
+	{
+		ConsumeScan(info.get());
+		CHECK(info->scan->finished);
+		CHECK(info->scan->error == std::errc::timed_out);
+	}
+
+	// The pool still lists a folder that answers.
+	std::filesystem::path healthy = root / "healthy";
+	std::filesystem::create_directories(healthy);
+	for (int i = 0; i < 10; ++i)
+		std::ofstream(healthy / ("file_" + std::to_string(i) + ".txt")) << i;
+
+	ImFileDialogInfo info;
+	info.directoryPath = healthy;
+	info.service = service;
+	info.syncScanTimeoutMs = 5000.0;
+	ParseFilters(&info);
+
+	auto start = std::chrono::steady_clock::now();
+	RefreshInfo(&info);
+	CHECK(info.scan->finished);
+	CHECK(!info.scan->error);
+	CHECK(info.currentFiles.size() == 10);
+	CHECK(ElapsedSince(start) < 1000.0);
+
+	// Released workers hand their slots back.
+	mount->release();
+	for (int i = 0; i < 500; ++i)
+	{
+		{
+			std::lock_guard<std::mutex> lock(service->pool.mutex);
+			if (service->pool.stalledThreads == 0)
+				break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	std::lock_guard<std::mutex> lock(service->pool.mutex);
+	CHECK(service->pool.stalledThreads == 0);
+}
+
+static void TestLazyListingsServeOnlyLazyDialogs(const std::filesystem::path& root)
+{
+	std::filesystem::path directory = root / "lazy";
+	std::filesystem::create_directories(directory);
+	std::ofstream(directory / "file.txt") << "lazy";
+
+	auto service = std::make_shared<ImFileDialogService>();
+	auto makeInfo = [&](ImFileDialogInfo& info, bool lazyMetadata)
+		{
+			info.directoryPath = directory;
+			info.service = service;
+			info.lazyMetadata = lazyMetadata;
+			info.syncScanTimeoutMs = 5000.0;
+			ParseFilters(&info);
+		};
+
+	ImFileDialogInfo lazy;
+	makeInfo(lazy, true);
+	RefreshInfo(&lazy);
+	CHECK(lazy.scan->finished && !lazy.scan->error);
+
+	// Finished scans are cached, but a lazy listing lacks the metadata an eager dialog shows.
+	ImFileDialogInfo eager;
+	makeInfo(eager, false);
+	CHECK(!LoadListing(&eager));
+
+	ImFileDialogInfo otherLazy;
+	makeInfo(otherLazy, true);
+	CHECK(LoadListing(&otherLazy));
+	CHECK(otherLazy.currentFiles.size() == 1);
+}
+
+static void TestWalkEntersCyclesOnce(const std::filesystem::path& root)
+{
+	std::filesystem::path directory = root / "walk";
+	std::filesystem::create_directories(directory / "a" / "b");
+	std::ofstream(directory / "a" / "needle_1.txt") << 1;
+	std::ofstream(directory / "a" / "b" / "needle_2.txt") << 2;
+
+	std::error_code error;
+	std::filesystem::create_directory_symlink(directory / "a", directory / "a" / "b" / "loop", error);
+
+	ImFileDialogInfo info;
+	info.directoryPath = directory;
+	info.recursiveSearch = true;
+	info.searchQuery = "needle";
+	ParseFilters(&info);
+
+	UpdateWalk(&info);
+	std::shared_ptr<ImFileDialogWalk> walk = info.walk;
+	CHECK(walk != nullptr);
+
+	for (int i = 0; i < 500 && walk && !walk->finished; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	UpdateWalk(&info);
+	CHECK(walk && walk->finished);
+	CHECK(walk && walk->files.size() == 2);
+	CHECK(walk && walk->runningWorkers == 0);
+}
+
+static void TestChangesKeepUnchangedWork(const std::filesystem::path& root)
+{
+	std::filesystem::path directory = root / "changes";
+	std::filesystem::create_directories(directory);
+	for (const char* name : { "a.txt", "b.txt", "c.txt" })
+		std::ofstream(directory / name) << name;
+
+	ImFileDialogInfo info;
+	info.directoryPath = directory;
+	info.lazyMetadata = true;
+	info.syncScanTimeoutMs = 5000.0;
+	ParseFilters(&info);
+	RefreshInfo(&info);
+	CHECK(info.currentFiles.size() == 3);
+
+	// Queued metadata and computed column values, named after their entries.
+	auto values = std::make_shared<ImFileDialogColumnValues>();
+	values->cells.resize(1);
+	ImFileDialogMetadata* metadata = GetMetadata(&info);
+	for (size_t i = 0; i < info.currentFiles.size(); ++i)
+	{
+		std::string name(info.currentFiles.name(i));
+		values->cells[0].files[(uint32_t)i] = name;
+		metadata->bulk.push_back({ false, (uint32_t)i, name });
+	}
+	info.columnValues = values;
+
+	// A change is read from the folder listed, even while another one is being opened.
+	info.directoryPath = root;
+	info.watch = std::make_shared<ImFileDialogWatch>();
+	std::filesystem::remove(directory / "b.txt");
+	std::ofstream(directory / "d.txt") << "d";
+	ReadChanges(&info, { "b.txt", "d.txt" });
+
+	std::shared_ptr<ImFileDialogWatchChanges> changes = info.watch->changes;
+	for (int i = 0; i < 500 && !changes->finished; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	CHECK(changes->finished && changes->files.size() == 1);
+
+	ApplyChanges(&info, *changes);
+	CHECK(info.currentFiles.size() == 3);
+	CHECK(info.columnValues == values && info.metadata.get() == metadata);
+	CHECK(values->cells[0].files.size() == 2);
+	for (const auto& cell : values->cells[0].files)
+		CHECK(cell.first < info.currentFiles.size() && info.currentFiles.name(cell.first) == cell.second);
+	CHECK(metadata->bulk.size() == 2);
+	for (const ImFileDialogMetadataRequest& request : metadata->bulk)
+		CHECK(request.index < info.currentFiles.size() && info.currentFiles.name(request.index) == request.name);
+}
+
+static void TestMultiDotFilters()
+{
+	ImFileDialogFilter filter;
+	filter.add(".tar.gz");
+	filter.add(".png");
+	CHECK(filter.matches("backup.tar.gz"));
+	CHECK(filter.matches("BACKUP.TAR.GZ"));
+	CHECK(filter.matches("image.png"));
+	CHECK(!filter.matches("notes.gz"));
+	CHECK(!filter.matches("backup.tar"));
+}
+
+static void TestSelectAllCoversListedEntries()
+{
+	// Selecting everything while three files are listed leaves those streamed in later alone.
+	ImFileDialogSelection selection;
+	selection.selectAll(3);
+	CHECK(selection.contains(0) && selection.contains(2));
+	CHECK(!selection.contains(3));
+	CHECK(!selection.empty());
+
+	selection.set(4, true);
+	selection.set(2, false);
+	selection.remap({ 0, UINT32_MAX, 1, 2, 3 });
+	CHECK(selection.contains(0));
+	CHECK(!selection.contains(1) && !selection.contains(2));
+	CHECK(selection.contains(3));
+
+	selection.clear();
+	CHECK(selection.empty() && !selection.contains(0));
+
+	// Clearing every entry one by one leaves an empty selection, after a remap too.
+	selection.selectAll(2);
+	selection.set(5, true);
+	selection.set(0, false);
+	selection.set(1, false);
+	CHECK(!selection.empty());
+	selection.remap({ 0, 1, 2, 3, 4, UINT32_MAX });
+	CHECK(selection.empty());
+}
+
+// Runs UpdateTree until `done` holds, while the tree's listings and checks finish on workers.
+template <typename Done>
+static bool UpdateTreeUntil(ImFileDialogInfo* info, Done done)
+{
+	for (int i = 0; i < 500; ++i)
+	{
+		UpdateTree(info);
+		if (done())
+			return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	return false;
+}
+
+static void TestTreeRevealsAndReloads(const std::filesystem::path& root)
+{
+	std::filesystem::path directory = root / "tree";
+	std::filesystem::create_directories(directory / "a" / "b");
+
+	ImFileDialogInfo info;
+	info.directoryPath = directory / "a" / "b";
+	info.showTree = true;
+	ParseFilters(&info);
+
+	// The folders above the one on screen are expanded, and it is scrolled to.
+	CHECK(UpdateTreeUntil(&info, [&]() { return !info.tree->revealing; }));
+	ImFileDialogTree* tree = info.tree.get();
+	uint32_t folder = FindTreeNode(tree, info.directoryPath);
+	CHECK(folder != UINT32_MAX && tree->scrollTo == folder);
+	CHECK(tree->nodes[FindTreeNode(tree, directory / "a")].expanded);
+
+	// A folder written after it was listed is listed again, keeping its expanded children.
+	std::filesystem::create_directory(directory / "a" / "c");
+	CHECK(UpdateTreeUntil(&info, [&]()
+		{
+			tree->nextCheck = std::chrono::steady_clock::time_point();
+			return FindTreeNode(tree, directory / "a" / "c") != UINT32_MAX;
+		}));
+	CHECK(tree->nodes[FindTreeNode(tree, directory / "a")].expanded);
+	CHECK(FindTreeNode(tree, info.directoryPath) != UINT32_MAX);
+}
+
+static void TestAdoptedSpeculationListsEverything(const std::filesystem::path& root)
+{
+	std::filesystem::path directory = root / "speculation";
+	std::filesystem::create_directories(directory);
+	for (int i = 0; i < 20; ++i)
+		std::ofstream(directory / ("file_" + std::to_string(i) + ".txt")) << i;
+
+	ImFileDialogInfo info;
+	info.directoryPath = directory;
+	info.speculativeScan = true;
+	ParseFilters(&info);
+
+	// A scan stopped by its cap reports it instead of finishing as the whole folder.
+	std::shared_ptr<ImFileDialogScanJob> capped = MakeScanJob(&info, directory);
+	capped->maxEntries = 5;
+	ScanDirectory(capped);
+	CHECK(capped->finished && capped->error == std::errc::value_too_large);
+
+	// Opening the folder lifts the cap of the speculative scan it adopts.
+	std::shared_ptr<ImFileDialogScanJob> job = MakeScanJob(&info, directory);
+	job->maxEntries = 5;
+	info.speculation = std::make_shared<ImFileDialogSpeculation>();
+	info.speculation->pending = job;
+	CHECK(AdoptSpeculation(&info));
+	CHECK(job->maxEntries == SIZE_MAX);
+
+	ScanDirectory(job);
+	ConsumeScan(&info);
+	CHECK(info.scan->finished && !info.scan->error);
+	CHECK(info.currentFiles.size() == 20);
+}
+
+template <typename Done>
+static bool WaitUntil(Done done)
+{
+	for (int i = 0; i < 500; ++i)
+	{
+		if (done())
+			return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	return false;
+}
+
+static std::string ReadText(const std::filesystem::path& path)
+{
+	std::ifstream file(path);
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void TestPlacesAndConfirmChecksOffTheFrame(const std::filesystem::path& root)
+{
+	std::filesystem::path directory = root / "places";
+	std::filesystem::create_directories(directory);
+	std::ofstream(directory / "file.txt") << "x";
+	std::ofstream(directory / "places.txt") << "bookmark /from-file\nrecent /recent\n";
+
+	ImFileDialogInfo info;
+	info.placesFile = directory / "places.txt";
+	info.bookmarks.push_back("/set");
+
+	// A save issued while the file is still being read keeps the places not merged yet.
+	LoadPlaces(&info);
+	SavePlaces(&info);
+	CHECK(WaitUntil([&]() { return UpdatePlaces(&info); }));
+	CHECK(info.bookmarks.size() == 2 && info.bookmarks[0] == "/set" && info.bookmarks[1] == "/from-file");
+	CHECK(info.recentDirectories.size() == 1 && info.recentDirectories[0] == "/recent");
+	CHECK(WaitUntil([&]() { return ReadText(info.placesFile) == "bookmark /set\nbookmark /from-file\nrecent /recent\n"; }));
+
+	// The confirm buttons read what the typed name is on a worker.
+	std::shared_ptr<ImFileDialogPathCheck> file = StartPathCheck(&info, directory / "file.txt");
+	std::shared_ptr<ImFileDialogPathCheck> folder = StartPathCheck(&info, directory);
+	std::shared_ptr<ImFileDialogPathCheck> missing = StartPathCheck(&info, directory / "missing");
+	CHECK(WaitUntil([&]() { return file->finished && folder->finished && missing->finished; }));
+	CHECK(file->exists && file->isRegularFile && !file->isDirectory);
+	CHECK(folder->exists && folder->isDirectory && !folder->isRegularFile);
+	CHECK(!missing->exists);
+}
+
+static void TestGlobFilters()
+{
+	// '?' takes exactly one character; patterns are lowercase, names are folded.
+	CHECK(MatchGlob("frame_????.exr", "frame_0001.exr"));
+	CHECK(MatchGlob("frame_????.exr", "FRAME_0001.EXR"));
+	CHECK(!MatchGlob("frame_????.exr", "frame_01.exr"));
+	CHECK(!MatchGlob("frame_????.exr", "frame_00001.exr"));
+	CHECK(MatchGlob("*_final*.psd", "poster_FINAL_v2.psd"));
+	CHECK(MatchGlob("*.tar.gz", "a.b.tar.gz"));
+	CHECK(!MatchGlob("*.tar.gz", "a.tar.gz.part"));
+	CHECK(MatchGlob("*", ""));
+
+	// Filters past the 64th have no bit in the entry mask; the display projection matches them
+	// against the name instead.
+	ImFileDialogInfo info;
+	for (int i = 0; i < 69; ++i)
+		info.filters.push_back("Filter " + std::to_string(i) + "|.ext" + std::to_string(i));
+	info.filters.push_back("Frames|frame_????.exr");
+	ParseFilters(&info);
+	CHECK(info.parsedFilters.size() == 70);
+
+	ImFileDialogEntryList entries;
+	for (const char* name : { "frame_0001.exr", "frame_01.exr", "notes.ext3" })
+		entries.push_back(name, MatchFilters(info.parsedFilters, name));
+
+	std::vector<uint32_t> order = { 0, 1, 2 };
+	std::vector<uint32_t> display;
+	UpdateDisplay(display, order, entries, &info.parsedFilters.at(69), 69, nullptr);
+	CHECK(display == std::vector<uint32_t>{ 0 });
+	UpdateDisplay(display, order, entries, &info.parsedFilters.at(3), 3, nullptr);
+	CHECK(display == std::vector<uint32_t>{ 2 });
+}
+
+static std::vector<uint32_t> SearchMatches(ImFileDialogInfo* info, const char* query)
+{
+	info->searchQuery = query;
+	UpdateSearch(info);
+	std::vector<uint32_t> matches = info->search->files.matches;
+	std::sort(matches.begin(), matches.end());
+	return matches;
+}
+
+static void TestIncrementalSearch()
+{
+	// Every offset around the 16-byte blocks the SSE2 pass compares at once.
+	for (size_t shift = 0; shift < 40; ++shift)
+	{
+		std::string names = std::string(shift, 'x') + "needle" + std::string(20, 'y');
+		std::vector<size_t> found;
+		FindAll(names, "needle", [&found](size_t position) { found.push_back(position); });
+		CHECK(found == std::vector<size_t>{ shift });
+	}
+
+	ImFileDialogInfo info;
+	for (const char* name : { "frame_1.exr", "frame_2.exr", "FRAME_10.exr", "notes.txt", "abcdefghijklneedle.txt" })
+		info.currentFiles.push_back(name, 0);
+
+	CHECK((SearchMatches(&info, "frame") == std::vector<uint32_t>{ 0, 1, 2 }));
+
+	// A longer query is looked for only among the previous matches: an entry dropped from them
+	// is not found again.
+	ImFileDialogSearchList& files = info.search->files;
+	files.matches.erase(std::find(files.matches.begin(), files.matches.end(), 2u));
+	files.matched[2] = 0;
+	CHECK((SearchMatches(&info, "frame_1") == std::vector<uint32_t>{ 0 }));
+
+	// A shorter one searches the whole listing again.
+	CHECK((SearchMatches(&info, "frame") == std::vector<uint32_t>{ 0, 1, 2 }));
+	CHECK((SearchMatches(&info, "frame_1") == std::vector<uint32_t>{ 0, 2 }));
+
+	// Bytes 59 to 64 of the packed names, across a block boundary.
+	CHECK((SearchMatches(&info, "needle") == std::vector<uint32_t>{ 4 }));
+	CHECK(info.search->files.matched[4] == 1 && info.search->files.matched[0] == 0);
+}
+
+// Names and sizes drawn from small ranges, so most sort keys are shared by several entries.
+static void AppendTiedEntries(ImFileDialogEntryList& entries, size_t count, uint32_t& seed)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		std::string name = "file_" + std::to_string(seed >> 28) + (seed & 0x100 ? ".PNG" : ".png");
+		entries.push_back(name, (seed >> 8) % 7, ImFileDialogEntryList::unknownTime, 0);
+	}
+}
+
+static std::vector<uint32_t> FullSort(const ImFileDialogEntryList& entries, ImGuiFileDialogSortColumn column, bool descending)
+{
+	std::vector<uint32_t> order(entries.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), ImFileDialogEntryCompare{ &entries, column, descending });
+	return order;
+}
+
+static void TestIncrementalMerge()
+{
+	// Appending in batches merges each one in and ends on the order of a single full sort, ties
+	// ordered by index.
+	for (ImGuiFileDialogSortColumn column : { ImGuiFileDialogSortColumn_Name, ImGuiFileDialogSortColumn_NaturalName, ImGuiFileDialogSortColumn_Size, ImGuiFileDialogSortColumn_Type })
+	{
+		for (bool descending : { false, true })
+		{
+			ImFileDialogEntryList entries;
+			std::vector<uint32_t> order;
+			uint32_t seed = 1;
+
+			for (size_t batch : { 1, 7, 100, 3, 500 })
+			{
+				AppendTiedEntries(entries, batch, seed);
+				CHECK(UpdateSortOrder(order, entries, false, column, descending));
+			}
+			CHECK(order == FullSort(entries, column, descending));
+		}
+	}
+
+	// Past parallelSortThreshold a batch is sorted in chunks on several threads, even on a
+	// machine with a single core.
+	ImFileDialogEntryList entries;
+	uint32_t seed = 2;
+	AppendTiedEntries(entries, parallelSortThreshold * 2 + 123, seed);
+
+	std::vector<uint32_t> order(entries.size());
+	std::iota(order.begin(), order.end(), 0);
+	ImFileDialogEntryCompare bySize = { &entries, ImGuiFileDialogSortColumn_Size, false };
+	ParallelSort(order.begin(), order.end(), bySize, 4);
+	CHECK(order == FullSort(entries, ImGuiFileDialogSortColumn_Size, false));
+
+	order.clear();
+	CHECK(UpdateSortOrder(order, entries, true, ImGuiFileDialogSortColumn_Name, true));
+	CHECK(order == FullSort(entries, ImGuiFileDialogSortColumn_Name, true));
+
+	AppendTiedEntries(entries, 1000, seed);
+	CHECK(UpdateSortOrder(order, entries, false, ImGuiFileDialogSortColumn_Name, true));
+	CHECK(order == FullSort(entries, ImGuiFileDialogSortColumn_Name, true));
+}
+
+static std::string CollationKey(std::string_view name)
+{
+	std::string key;
+	AppendCollationKey(key, name);
+	return key;
+}
+
+static std::vector<std::string> SortedNames(const std::vector<std::string>& names, ImGuiFileDialogSortColumn column)
+{
+	ImFileDialogEntryList entries;
+	for (const std::string& name : names)
+		entries.push_back(name, 0);
+
+	std::vector<uint32_t> order;
+	UpdateSortOrder(order, entries, true, column, false);
+
+	std::vector<std::string> sorted;
+	for (uint32_t index : order)
+		sorted.push_back(std::string(entries.name(index)));
+	return sorted;
+}
+
+static void TestNaturalSort()
+{
+	// A digit run becomes '0', its length without leading zeros as one byte, then the digits.
+	CHECK(CollationKey("frame_2") == std::string("frame_0\x01" "2"));
+	CHECK(CollationKey("frame_10") == std::string("frame_0\x02" "10"));
+	CHECK(CollationKey("frame_2") < CollationKey("frame_10"));
+	CHECK(CollationKey("A01") == CollationKey("a1"));
+	CHECK(CollationKey("x12345678901") == std::string("x0\x0b" "12345678901"));
+	CHECK(CollationKey("x99999999") < CollationKey("x12345678901"));
+
+	// Leading zeros and case tie on the key and fall back to the name.
+	std::vector<std::string> expected = {
+		"a01", "a1", "a2", "B3", "b3", "frame_2", "frame_10",
+		"x9", "x999999999", "x1000000000", "x12345678901", "x12345678902",
+	};
+	std::vector<std::string> names(expected.rbegin(), expected.rend());
+	CHECK(SortedNames(names, ImGuiFileDialogSortColumn_NaturalName) == expected);
+
+	// The plain name sort keeps comparing bytes.
+	std::vector<std::string> plain = SortedNames({ "frame_2", "frame_10" }, ImGuiFileDialogSortColumn_Name);
+	CHECK(plain.size() == 2 && plain[0] == "frame_10");
+}
+
+static void TestWatchCatchesUpAndKeepsSelection(const std::filesystem::path& root)
+{
+#ifdef __linux__
+	std::filesystem::path directory = root / "watch";
+	std::filesystem::create_directories(directory);
+	for (const char* name : { "a.txt", "b.txt" })
+		std::ofstream(directory / name) << name;
+
+	ImFileDialogInfo info;
+	info.directoryPath = directory;
+	info.multiSelect = true;
+	info.syncScanTimeoutMs = 5000.0;
+	ParseFilters(&info);
+	RefreshInfo(&info);
+
+	// The listing was read before the watch was added, so it is read once more.
+	StartWatch(&info);
+	CHECK(WaitUntil([&]() { return info.watch->ready.load(); }));
+	PollWatch(&info);
+	CHECK(info.refreshInfo && info.watch->caughtUp);
+
+	// A listing read with the watch in place is trusted.
+	RefreshInfo(&info);
+	info.watch->caughtUp = false;
+	PollWatch(&info);
+	CHECK(!info.refreshInfo && info.watch->caughtUp);
+
+	// A modified file is re-added under its name and stays selected.
+	uint32_t a = info.currentFiles.name(0) == "a.txt" ? 0 : 1;
+	info.selection.set(a, true);
+	std::ofstream(directory / "a.txt") << "modified";
+	ReadChanges(&info, { "a.txt" });
+	std::shared_ptr<ImFileDialogWatchChanges> changes = info.watch->changes;
+	CHECK(WaitUntil([&]() { return changes->finished.load(); }));
+
+	ApplyChanges(&info, *changes);
+	CHECK(info.currentFiles.size() == 2 && info.currentFiles.name(1) == "a.txt");
+	CHECK(info.selection.contains(1) && !info.selection.contains(0));
+#else
+	(void)root;
+#endif
+}
+
+static void TestColumnCacheKeys()
+{
+	// Columns sharing a name on two dialogs of one service never share cached values...
+	auto service = std::make_shared<ImFileDialogService>();
+	ImFileDialogInfo first;
+	ImFileDialogInfo second;
+	for (ImFileDialogInfo* info : { &first, &second })
+	{
+		info->service = service;
+		info->columns.push_back({ "Owner", 90.0f, ImGuiFileDialogColumnCost_Expensive, [](const ImFileDialogColumnEntry&) { return std::string(); } });
+		info->columns.push_back({ "Owner", 90.0f, ImGuiFileDialogColumnCost_Expensive, [](const ImFileDialogColumnEntry&) { return std::string(); } });
+	}
+	CHECK(ColumnCacheKey(&first, 0) != ColumnCacheKey(&second, 0));
+	CHECK(ColumnCacheKey(&first, 0) != ColumnCacheKey(&first, 1));
+	CHECK(ColumnCacheKey(&first, 0) == ColumnCacheKey(&first, 0));
+
+	// ...unless they name the same provider.
+	first.columns[0].cacheKey = "owner";
+	second.columns[1].cacheKey = "owner";
+	CHECK(ColumnCacheKey(&first, 0) == ColumnCacheKey(&second, 1));
+	CHECK(ColumnCacheKey(&first, 0) != ColumnCacheKey(&second, 0));
+}
+
+int main()
+{
+	std::filesystem::path root = std::filesystem::temp_directory_path() / "imgui_filedialog_tests";
+	std::filesystem::create_directories(root);
+
+	TestZip64OffsetPastEnd();
+	TestTarMemberSizeOverflow();
+	TestMultiDotFilters();
+	TestGlobFilters();
+	TestIncrementalSearch();
+	TestNaturalSort();
+	TestIncrementalMerge();
+	TestSelectAllCoversListedEntries();
+	TestMapFileSkipsSpecialFiles(root);
+	TestStalledListings(root);
+	TestLazyListingsServeOnlyLazyDialogs(root);
+	TestAdoptedSpeculationListsEverything(root);
+	TestWalkEntersCyclesOnce(root);
+	TestChangesKeepUnchangedWork(root);
+	TestColumnCacheKeys();
+	TestWatchCatchesUpAndKeepsSelection(root);
+	TestTreeRevealsAndReloads(root);
+	TestPlacesAndConfirmChecksOffTheFrame(root);
+
+	std::filesystem::remove_all(root);
+
+	if (failures > 0)
+		std::fprintf(stderr, "%d checks failed\n", failures);
+	return failures > 0 ? 1 : 0;
+}